@@ -1,12 +1,17 @@
 #pragma once
 
 #include "ast.h"
+#include "flat_ast.h"
+#include "ops.h"
+#include "overload.h"
+#include "scope.h"
+#include "symbol.h"
 #include "types.h"
 
+#include <array>
+#include <cstddef>
 #include <memory>
-#include <string>
-#include <unordered_map>
-#include <unordered_set>
+#include <vector>
 
 /**
  * @brief Classes and types related to type checking.
@@ -14,82 +19,189 @@
 namespace stapl::types {
 /**
  * @brief A visitor for annotating AST nodes with types.
- * @todo Add support for block scopes.
  */
 class TypeAnnotator {
 private:
   /**
-   * @brief Type names of variables in current function.
+   * @brief Types of variables in scope in the current function. Arguments are
+   * bound in the outermost scope, and each compound statement opens a scope.
    * @todo Add support for generics and user-defined types.
    */
-  std::unordered_map<std::string, std::string> variable_type_names = {};
+  util::ScopeStack<TypeId> variable_types;
 
   /**
-   * @brief Type information of functions.
+   * @brief Overloads of functions declared through this annotator.
    */
-  std::unordered_map<std::string, std::vector<FuncTypeInfo>> func_types = {};
+  OverloadTable overloads;
+
+  /**
+   * @brief Signatures of all functions of the module, shared with other
+   * annotators, or ``nullptr`` if the annotator resolves calls through its own
+   * ``overloads``.
+   */
+  const OverloadTable *shared_signatures = nullptr;
+
+  /**
+   * @brief Scratch stack of argument types. A call pushes the types of its
+   * arguments, resolves the overload and pops them, so nested calls share the
+   * stack and resolving a call does not allocate.
+   */
+  std::vector<TypeId> arg_type_stack;
+
+  /**
+   * @brief Get the result type of an operator applied to operands.
+   * @param op The operator.
+   * @param arity The number of operands.
+   * @param arg_types The types of the operands.
+   * @return The type of the result.
+   * @throw std::logic_error If no signature of ``op`` matches.
+   */
+  static TypeId op_return_type(ast::Op op, std::size_t arity,
+                               const std::array<TypeId, 2> &arg_types);
+
+  /**
+   * @brief Resolve a call whose argument types are on top of
+   * ``arg_type_stack``, and pop them.
+   * @param callee The name of the called function.
+   * @param args_begin The index of the first argument type in the stack.
+   * @return The return type of the matching overload.
+   * @throw std::logic_error If no overload of ``callee`` matches.
+   */
+  TypeId resolve_call(util::Symbol callee, std::size_t args_begin);
+
+  /**
+   * @brief Get the type of a variable in scope.
+   * @param name The name of the variable.
+   * @return The type of the innermost variable named ``name``.
+   * @throw std::logic_error If no variable named ``name`` is in scope.
+   */
+  TypeId variable_type(util::Symbol name) const;
+
+  /**
+   * @brief Declare a variable in the innermost scope.
+   * @param name The name of the variable.
+   * @param type The type of the variable.
+   * @throw std::logic_error If the innermost scope declares ``name`` already.
+   */
+  void define_variable(util::Symbol name, TypeId type);
+
+  /**
+   * @brief Check that the type of an assigned expression matches the variable.
+   * @param var_name The name of the assigned variable.
+   * @param rhs_type The type of the assigned expression.
+   */
+  void check_assignment(util::Symbol var_name, TypeId rhs_type);
+
+  /**
+   * @brief Check that a condition expression is boolean.
+   * @param condition_type The type of the condition.
+   */
+  void check_condition(TypeId condition_type);
+
+  /**
+   * @brief Get the signatures used to resolve calls.
+   * @return ``shared_signatures`` if set, otherwise ``overloads``.
+   */
+  const OverloadTable &signatures() const;
+
+  /**
+   * @brief Register the signature of a function, unless the annotator uses
+   * shared signatures, which already contain it.
+   * @param proto The prototype of the function.
+   */
+  void declare_function(const ast::PrototypeNode &proto);
+
+  /**
+   * @brief Bind the arguments of a function as the variables of the current
+   * function.
+   * @param proto The prototype of the function.
+   */
+  void enter_function(const ast::PrototypeNode &proto);
+
+  /**
+   * @brief Annotate the types of an expression of a flat module in a single
+   * pass.
+   * @param exprs The expression pool.
+   * @param range The range of the expression in ``exprs``.
+   * @return The annotated type of the expression.
+   */
+  TypeId annotate_flat_expr(ast::FlatExprPool &exprs, ast::IndexRange range);
+
+  /**
+   * @brief Annotate the types of a statement of a flat module.
+   * @param module The flat module.
+   * @param stmt The statement.
+   */
+  void annotate_flat_stmt(ast::FlatModule &module, ast::FlatStmtRef stmt);
 
 public:
   /**
-   * @brief Default constructor.
+   * @brief Default constructor. Functions are declared as they are visited.
    */
   TypeAnnotator();
 
+  /**
+   * @brief Instantiate an annotator resolving calls through the signatures of
+   * all functions of a module, collected beforehand.
+   * @param signatures The signatures, which must outlive the annotator.
+   */
+  explicit TypeAnnotator(const OverloadTable &signatures);
+
   /**
    * @brief Annotate the type of a integer literal expression node and return
-   * the annotated type name.
+   * the annotated type.
    * @param node The node to annotate.
    * @return The annotated type of the node.
    */
-  std::string operator()(ast::LiteralExprNode<int> &node);
+  TypeId operator()(ast::LiteralExprNode<int> &node);
 
   /**
    * @brief Annotate the type of a float literal expression node and return
-   * the annotated type name.
+   * the annotated type.
    * @param node The node to annotate.
    * @return The annotated type of the node.
    */
-  std::string operator()(ast::LiteralExprNode<double> &node);
+  TypeId operator()(ast::LiteralExprNode<double> &node);
 
   /**
    * @brief Annotate the type of a boolean literal expression node and return
-   * the annotated type name.
+   * the annotated type.
    * @param node The node to annotate.
    * @return The annotated type of the node.
    */
-  std::string operator()(ast::LiteralExprNode<bool> &node);
+  TypeId operator()(ast::LiteralExprNode<bool> &node);
 
   /**
    * @brief Annotate the type of a variable expression node and return the
-   * annotated type name.
+   * annotated type.
    * @param node The node to annotate.
    * @return The annotated type of the node.
    */
-  std::string operator()(ast::VariableExprNode &node);
+  TypeId operator()(ast::VariableExprNode &node);
 
   /**
    * @brief Annotate the type of a unary expression node and return the
-   * annotated type name.
+   * annotated type.
    * @param node The node to annotate.
    * @return The annotated type of the node.
    */
-  std::string operator()(std::unique_ptr<ast::UnaryExprNode> &node);
+  TypeId operator()(std::unique_ptr<ast::UnaryExprNode> &node);
 
   /**
    * @brief Annotate the type of a binary expression node and return the
-   * annotated type name.
+   * annotated type.
    * @param node The node to annotate.
    * @return The annotated type of the node.
    */
-  std::string operator()(std::unique_ptr<ast::BinaryExprNode> &node);
+  TypeId operator()(std::unique_ptr<ast::BinaryExprNode> &node);
 
   /**
    * @brief Annotate the type of a call expression node and return the annotated
-   * type name.
+   * type.
    * @param node The node to annotate.
    * @return The annotated type of the node.
    */
-  std::string operator()(std::unique_ptr<ast::CallExprNode> &node);
+  TypeId operator()(std::unique_ptr<ast::CallExprNode> &node);
 
   /**
    * @brief Register the type of the variable declared by ``let`` statement.
@@ -146,5 +258,62 @@ public:
    * @param node The node to annotate.
    */
   void operator()(ast::FunctionDeclNode &node);
+
+  /**
+   * @brief Annotate the types of all expressions in a flat module. All
+   * functions are declared first, so that they can call each other regardless
+   * of their order.
+   * @param module The flat module to annotate.
+   */
+  void operator()(ast::FlatModule &module);
+
+  /**
+   * @brief Annotate the types of the body of a function in a flat module,
+   * whose signature must be declared already.
+   * @param module The flat module.
+   * @param index The index of the function in ``module.functions``.
+   */
+  void annotate_function(ast::FlatModule &module, std::size_t index);
 };
+
+/**
+ * @brief Collect the signatures of all functions of a module.
+ * @param module The module.
+ * @return The overloads of all functions.
+ * @throw std::logic_error If two functions have a duplicate or ambiguous
+ * signature.
+ */
+OverloadTable collect_signatures(const ast::Module &module);
+
+/**
+ * @brief Collect the signatures of all functions of a flat module.
+ * @param module The flat module.
+ * @return The overloads of all functions.
+ * @throw std::logic_error If two functions have a duplicate or ambiguous
+ * signature.
+ */
+OverloadTable collect_signatures(const ast::FlatModule &module);
+
+/**
+ * @brief Type check a module in two phases.
+ *
+ * The signatures of all functions are collected first, then the function
+ * bodies are annotated concurrently, each thread with its own annotator
+ * sharing the signatures. Functions may call functions declared later.
+ * @param module The module to annotate.
+ * @param jobs Maximum number of threads to use.
+ * @throw std::logic_error If the module does not type check. When several
+ * functions fail, the error of the first one is thrown.
+ */
+void annotate_module(ast::Module &module, unsigned jobs);
+
+/**
+ * @brief Type check a flat module in two phases, like ``annotate_module`` for
+ * a tree module.
+ * @param module The flat module to annotate.
+ * @param jobs Maximum number of threads to use.
+ * @throw std::logic_error If the module does not type check. When several
+ * functions fail, the error of the first one is thrown.
+ */
+void annotate_module(ast::FlatModule &module, unsigned jobs);
 }; // namespace stapl::types
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace stapl::util {
+/**
+ * @brief Bump allocator handing out memory from large blocks.
+ *
+ * Memory is never freed one allocation at a time; all blocks are freed at once
+ * when the arena is destroyed. An arena is not safe to use from multiple
+ * threads, but each thread has its own current arena.
+ */
+class Arena {
+private:
+  /**
+   * @brief Blocks of memory allocated so far.
+   */
+  std::vector<std::unique_ptr<std::byte[]>> blocks;
+
+  /**
+   * @brief Next free byte in the last block.
+   */
+  std::byte *cursor = nullptr;
+
+  /**
+   * @brief End of the last block.
+   */
+  std::byte *limit = nullptr;
+
+  /**
+   * @brief Size of a block.
+   */
+  std::size_t block_size;
+
+  /**
+   * @brief Number of bytes handed out, including padding for alignment.
+   */
+  std::size_t used = 0;
+
+  /**
+   * @brief Number of bytes allocated for blocks.
+   */
+  std::size_t reserved = 0;
+
+  /**
+   * @brief Arena of the current thread, or ``nullptr`` if there is none.
+   */
+  static thread_local Arena *current_arena;
+
+public:
+  /**
+   * @brief RAII object installing an arena as the current arena of the thread,
+   * and restoring the previous one when it is destroyed.
+   */
+  class Scope {
+  private:
+    /**
+     * @brief Arena that was current before this scope.
+     */
+    Arena *previous;
+
+  public:
+    /**
+     * @brief Install an arena as the current arena.
+     * @param arena Arena to install, or ``nullptr`` to allocate from the heap.
+     */
+    explicit Scope(Arena *arena);
+
+    /**
+     * @brief Deleted copy constructor.
+     */
+    Scope(const Scope &) = delete;
+
+    /**
+     * @brief Deleted copy assignment operator.
+     */
+    Scope &operator=(const Scope &) = delete;
+
+    /**
+     * @brief Restore the previous arena.
+     */
+    ~Scope();
+  };
+
+  /**
+   * @brief Instantiate an empty arena.
+   * @param block_size Size of the blocks to allocate.
+   */
+  explicit Arena(std::size_t block_size = 1 << 16);
+
+  /**
+   * @brief Deleted copy constructor.
+   */
+  Arena(const Arena &) = delete;
+
+  /**
+   * @brief Deleted copy assignment operator.
+   */
+  Arena &operator=(const Arena &) = delete;
+
+  /**
+   * @brief Allocate memory from the arena.
+   * @param size Number of bytes to allocate.
+   * @param alignment Alignment of the memory, which must be a power of two no
+   * larger than ``alignof(std::max_align_t)``.
+   * @return Pointer to the allocated memory, which lives as long as the arena.
+   */
+  void *allocate(std::size_t size, std::size_t alignment);
+
+  /**
+   * @brief Get the number of bytes handed out by the arena.
+   * @return The number of bytes allocated from the arena.
+   */
+  std::size_t bytes_used() const;
+
+  /**
+   * @brief Get the number of bytes the arena has allocated for its blocks.
+   * @return The number of bytes in all blocks.
+   */
+  std::size_t bytes_reserved() const;
+
+  /**
+   * @brief Get the current arena of the thread.
+   * @return The installed arena, or ``nullptr`` if there is none.
+   */
+  static Arena *current();
+};
+} // namespace stapl::util
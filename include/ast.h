@@ -1,5 +1,12 @@
 #pragma once
 
+#include "arena.h"
+#include "ops.h"
+#include "symbol.h"
+#include "types.h"
+
+#include <cstddef>
+
 #include <map>
 #include <memory>
 #include <optional>
@@ -26,6 +33,38 @@ inline bool operator==(const std::unique_ptr<T> &p1,
   return *p1 == *p2;
 }
 
+/**
+ * @brief Base of AST nodes held by ``std::unique_ptr``, which are allocated
+ * from the current ``util::Arena`` of the thread if there is one.
+ *
+ * Each allocation is prefixed with the arena it came from. Deleting a node
+ * allocated from an arena runs its destructor but leaves the memory to the
+ * arena, so such a node must not outlive its arena.
+ */
+struct ArenaNode {
+  /**
+   * @brief Allocate a node from the current arena, or from the heap if there
+   * is none.
+   * @param size Size of the node.
+   * @return Pointer to the memory for the node.
+   */
+  static void *operator new(std::size_t size);
+
+  /**
+   * @brief Free a node allocated from the heap. Nodes allocated from an arena
+   * are freed with the arena.
+   * @param ptr Pointer to the node.
+   */
+  static void operator delete(void *ptr);
+
+  /**
+   * @brief Comparision operator overload, which lets nodes default theirs.
+   * @param rhs ``ArenaNode`` on the RHS.
+   * @return Always ``true``.
+   */
+  bool operator==(const ArenaNode &rhs) const = default;
+};
+
 /**
  * @brief AST node for literal expressions, such as numbers.
  * @todo Add support for types other than ``int``, ``double`` and ``bool``.
@@ -39,7 +78,7 @@ template <typename T> struct LiteralExprNode {
   /**
    * @brief Type of the literal expression.
    */
-  std::optional<std::string> expr_type = {};
+  std::optional<types::TypeId> expr_type = {};
 
   /**
    * @brief Move constructor.
@@ -72,12 +111,12 @@ struct VariableExprNode {
   /**
    * @brief Variable name.
    */
-  std::string name;
+  util::Symbol name;
 
   /**
    * @brief Type of the variable expression.
    */
-  std::optional<std::string> expr_type = {};
+  std::optional<types::TypeId> expr_type = {};
 
   /**
    * @brief Move constructor.
@@ -88,7 +127,7 @@ struct VariableExprNode {
    * @brief Instantiate from variable name.
    * @param name Variable name.
    */
-  explicit VariableExprNode(const std::string &name);
+  explicit VariableExprNode(util::Symbol name);
 
   /**
    * @brief Move assignment operator.
@@ -115,11 +154,11 @@ using ExprNode = std::variant<LiteralExprNode<int>, LiteralExprNode<double>,
 /**
  * @brief AST node for unary expressions.
  */
-struct UnaryExprNode {
+struct UnaryExprNode : ArenaNode {
   /**
    * @brief Operator of the unary expression.
    */
-  std::string op;
+  Op op;
 
   /**
    * @brief Operand of the unary expression.
@@ -129,7 +168,7 @@ struct UnaryExprNode {
   /**
    * @brief Type of the unary expression.
    */
-  std::optional<std::string> expr_type = {};
+  std::optional<types::TypeId> expr_type = {};
 
   /**
    * @brief Move constructor.
@@ -141,7 +180,7 @@ struct UnaryExprNode {
    * @param op Operator of the unary expression.
    * @param rhs Operand of the unary expression.
    */
-  explicit UnaryExprNode(const std::string &op, ExprNode rhs);
+  explicit UnaryExprNode(Op op, ExprNode rhs);
 
   /**
    * @brief Move assignment operator.
@@ -159,11 +198,11 @@ struct UnaryExprNode {
 /**
  * @brief AST node for binary expressions.
  */
-struct BinaryExprNode {
+struct BinaryExprNode : ArenaNode {
   /**
    * @brief Operator of the binary expression.
    */
-  std::string op;
+  Op op;
 
   /**
    * @brief LHS of the binary expression.
@@ -178,7 +217,7 @@ struct BinaryExprNode {
   /**
    * @brief Type of the binary expression.
    */
-  std::optional<std::string> expr_type = {};
+  std::optional<types::TypeId> expr_type = {};
 
   /**
    * @brief Move constructor.
@@ -191,7 +230,7 @@ struct BinaryExprNode {
    * @param lhs LHS of the binary expression.
    * @param rhs RHS of the binary expression.
    */
-  explicit BinaryExprNode(const std::string &op, ExprNode lhs, ExprNode rhs);
+  explicit BinaryExprNode(Op op, ExprNode lhs, ExprNode rhs);
 
   /**
    * @brief Move assignment operator.
@@ -209,11 +248,11 @@ struct BinaryExprNode {
 /**
  * @brief AST node for function call expressions.
  */
-struct CallExprNode {
+struct CallExprNode : ArenaNode {
   /**
    * @brief Function to call.
    */
-  std::string callee;
+  util::Symbol callee;
 
   /**
    * @brief Arguments of the function call.
@@ -223,7 +262,7 @@ struct CallExprNode {
   /**
    * @brief Type of the function call expression.
    */
-  std::optional<std::string> expr_type = {};
+  std::optional<types::TypeId> expr_type = {};
 
   /**
    * @brief Move constructor.
@@ -235,7 +274,7 @@ struct CallExprNode {
    * @param callee Function to call.
    * @param args Arguments of the function call.
    */
-  explicit CallExprNode(const std::string &callee, std::vector<ExprNode> args);
+  explicit CallExprNode(util::Symbol callee, std::vector<ExprNode> args);
 
   /**
    * @brief Move assignment operator.
@@ -257,17 +296,17 @@ struct PrototypeNode {
   /**
    * @brief Function name.
    */
-  std::string name;
+  util::Symbol name;
 
   /**
-   * @brief Return type name of the function.
+   * @brief Return type of the function.
    */
-  std::string return_type;
+  types::TypeId return_type;
 
   /**
    * @brief Arguments names and types of the function.
    */
-  std::vector<std::pair<std::string, std::string>> args;
+  std::vector<std::pair<util::Symbol, types::TypeId>> args;
 
   /**
    * @brief Move constructor.
@@ -279,11 +318,12 @@ struct PrototypeNode {
    * and return type.
    * @param name Function name.
    * @param args Arguments names and types of the function.
-   * @param return_type Return type name of the function.
+   * @param return_type Return type of the function.
    */
-  explicit PrototypeNode(const std::string &name,
-                         std::vector<std::pair<std::string, std::string>> args,
-                         const std::string &return_type);
+  explicit PrototypeNode(
+      util::Symbol name,
+      std::vector<std::pair<util::Symbol, types::TypeId>> args,
+      types::TypeId return_type);
 
   /**
    * @brief Move assignment operator.
@@ -305,12 +345,12 @@ struct LetStmtNode {
   /**
    * @brief Variable name.
    */
-  std::string var_name;
+  util::Symbol var_name;
 
   /**
-   * @brief Type name of the variable.
+   * @brief Type of the variable.
    */
-  std::string var_type;
+  types::TypeId var_type;
 
   /**
    * @brief Move constructor.
@@ -320,10 +360,9 @@ struct LetStmtNode {
   /**
    * @brief Instantiate from variable name and type.
    * @param var_name Variable name.
-   * @param var_type Type name of the variable.
+   * @param var_type Type of the variable.
    */
-  explicit LetStmtNode(const std::string &var_name,
-                       const std::string &var_type);
+  explicit LetStmtNode(util::Symbol var_name, types::TypeId var_type);
 
   /**
    * @brief Move assignment operator.
@@ -345,7 +384,7 @@ struct AssignmentStmtNode {
   /**
    * @brief Name of the variable to be assigned.
    */
-  std::string var_name;
+  util::Symbol var_name;
 
   /**
    * @brief Expression to be assigned.
@@ -362,8 +401,7 @@ struct AssignmentStmtNode {
    * @param var_name Name of the variable to be assigned.
    * @param assign_expr Expression to be assigned.
    */
-  explicit AssignmentStmtNode(const std::string &var_name,
-                              ExprNode assign_expr);
+  explicit AssignmentStmtNode(util::Symbol var_name, ExprNode assign_expr);
 
   /**
    * @brief Move assignment operator.
@@ -476,7 +514,7 @@ using StmtNode = std::variant<
 /**
  * @brief AST node for if statement.
  */
-struct IfStmtNode {
+struct IfStmtNode : ArenaNode {
   /**
    * @brief Condition expression.
    */
@@ -524,7 +562,7 @@ struct IfStmtNode {
 /**
  * @brief AST node for while statement.
  */
-struct WhileStmtNode {
+struct WhileStmtNode : ArenaNode {
   /**
    * @brief Condition expression.
    */
@@ -564,7 +602,7 @@ struct WhileStmtNode {
 /**
  * @brief AST node for compound statement.
  */
-struct CompoundStmtNode {
+struct CompoundStmtNode : ArenaNode {
   /**
    * @brief Statements in the compound statement.
    */
@@ -652,6 +690,13 @@ struct Module {
    */
   std::string name;
 
+  /**
+   * @brief Arena the nodes of the module are allocated from, or ``nullptr`` if
+   * they are allocated from the heap. It is declared before ``decls`` so that
+   * the nodes are destroyed before their memory.
+   */
+  std::unique_ptr<util::Arena> arena;
+
   /**
    * @brief Declarations in the module.
    */
@@ -666,12 +711,17 @@ struct Module {
    * @brief Instantiate from name and declarations.
    * @param name Name of the module.
    * @param decls Declarations in the module.
+   * @param arena Arena the nodes in ``decls`` are allocated from, if any.
    */
-  explicit Module(const std::string &name, std::vector<DeclNode> decls);
+  explicit Module(const std::string &name, std::vector<DeclNode> decls,
+                  std::unique_ptr<util::Arena> arena = nullptr);
 
   /**
-   * @brief Move assignment operator.
+   * @brief Move assignment operator, which destroys the old declarations
+   * before their arena.
+   * @param rhs ``Module`` to move from.
+   * @return ``*this``.
    */
-  Module &operator=(Module &&) = default;
+  Module &operator=(Module &&rhs);
 };
 } // namespace stapl::ast
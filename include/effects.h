@@ -0,0 +1,162 @@
+#pragma once
+
+#include "ast.h"
+#include "flat_ast.h"
+#include "range.h"
+#include "symbol.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace stapl::analysis {
+/**
+ * @brief How a function may access memory visible to its caller, ordered from
+ * the strongest guarantee to the weakest.
+ */
+enum class Purity : std::uint8_t {
+  /**
+   * @brief The function accesses no memory but its own locals, so its result
+   * depends only on its arguments.
+   */
+  Pure,
+
+  /**
+   * @brief The function may read memory, but does not write any. No stapl
+   * statement reads memory yet, so only functions called through future
+   * memory operations can be read-only.
+   */
+  ReadOnly,
+
+  /**
+   * @brief The function may read and write any memory, like an extern
+   * function.
+   */
+  Effectful
+};
+
+/**
+ * @brief Get the name of a purity.
+ * @param purity The purity.
+ * @return The name of ``purity``, as used in effect reports.
+ */
+std::string_view purity_name(Purity purity);
+
+/**
+ * @brief Effects of the functions of a name.
+ *
+ * Overloads share their name in the generated module, so they are analyzed as
+ * one function whose effects are the join of the effects of the overloads.
+ */
+struct FunctionEffects {
+  /**
+   * @brief Name of the function.
+   */
+  util::Symbol name;
+
+  /**
+   * @brief How the function may access memory.
+   */
+  Purity purity = Purity::Effectful;
+
+  /**
+   * @brief Whether the function is an extern function.
+   */
+  bool is_extern = false;
+
+  /**
+   * @brief Whether the function is part of a cycle in the call graph.
+   */
+  bool recursive = false;
+
+  /**
+   * @brief Whether the function never calls itself, directly or through any
+   * callee, which is LLVM's ``norecurse``.
+   */
+  bool no_recurse = false;
+
+  /**
+   * @brief Whether the function never throws an exception, which is LLVM's
+   * ``nounwind``.
+   */
+  bool no_unwind = false;
+
+  /**
+   * @brief Whether the function may trap on an integer division, itself or in
+   * a callee.
+   */
+  bool may_trap = false;
+
+  /**
+   * @brief Whether every call of the function returns, which is LLVM's
+   * ``willreturn``.
+   */
+  bool will_return = false;
+};
+
+/**
+ * @brief Effects of the functions of a module.
+ */
+struct EffectFacts {
+  /**
+   * @brief Effects of each function name, in order of the first declaration of
+   * the name.
+   */
+  std::vector<FunctionEffects> functions;
+
+  /**
+   * @brief Mapping from function names to indices in ``functions``.
+   */
+  std::unordered_map<util::Symbol, std::size_t> indices;
+
+  /**
+   * @brief Get the effects of a function.
+   * @param name The name of the function.
+   * @return Pointer to the effects of the function, or ``nullptr`` if there
+   * is no function named ``name``.
+   */
+  const FunctionEffects *find(util::Symbol name) const;
+};
+
+/**
+ * @brief Analyze the effects of the functions of a module.
+ *
+ * Extern functions may do anything. A defined function inherits the effects
+ * of its callees, which are propagated bottom-up over the strongly connected
+ * components of the call graph. A function only returns for sure if it has no
+ * loops, is not recursive, cannot trap and calls only functions which return
+ * for sure.
+ * @param module The module.
+ * @param checked_division Whether integer division traps on a zero divisor
+ * or overflow.
+ * @param ranges Ranges of the expressions of ``module``, which rule out traps
+ * of some divisions, if they were analyzed.
+ * @return The effects of the functions of ``module``.
+ */
+EffectFacts analyze_effects(const ast::Module &module,
+                            bool checked_division = false,
+                            const RangeFacts *ranges = nullptr);
+
+/**
+ * @brief Analyze the effects of the functions of a flat module.
+ * @param module The flat module.
+ * @param checked_division Whether integer division traps on a zero divisor
+ * or overflow.
+ * @param ranges Ranges of the expressions of ``module``, which rule out traps
+ * of some divisions, if they were analyzed.
+ * @return The effects of the functions of ``module``.
+ */
+EffectFacts analyze_effects(const ast::FlatModule &module,
+                            bool checked_division = false,
+                            const RangeFacts *ranges = nullptr);
+
+/**
+ * @brief Describe the effects of the functions of a module.
+ * @param facts The effects of the functions.
+ * @return One line per function, such as ``fib: pure, recursive, nounwind``.
+ */
+std::string effects_report(const EffectFacts &facts);
+} // namespace stapl::analysis
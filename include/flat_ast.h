@@ -0,0 +1,309 @@
+#pragma once
+
+#include "ast.h"
+#include "symbol.h"
+#include "types.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace stapl::ast {
+/**
+ * @brief Index of a node in a pool of ``FlatModule``.
+ */
+using NodeIndex = std::uint32_t;
+
+/**
+ * @brief Half-open range of node indices.
+ */
+struct IndexRange {
+  /**
+   * @brief Index of the first node in the range.
+   */
+  NodeIndex begin;
+
+  /**
+   * @brief Index past the last node in the range.
+   */
+  NodeIndex end;
+
+  /**
+   * @brief Comparision operator overload.
+   * @param rhs ``IndexRange`` on the RHS.
+   * @return Whether ``this`` and ``rhs`` are the same range.
+   */
+  bool operator==(const IndexRange &rhs) const = default;
+};
+
+/**
+ * @brief Kinds of flat expression nodes.
+ */
+enum class FlatExprKind : std::uint8_t {
+  Int,
+  Float,
+  Bool,
+  Variable,
+  Unary,
+  Binary,
+  Call
+};
+
+/**
+ * @brief Pool of expression nodes, stored as a struct of arrays in post-order.
+ *
+ * Children come right before their parent, so an expression is a contiguous
+ * range whose last node is the root, and it can be evaluated by a single
+ * forward pass with a stack of values.
+ */
+struct FlatExprPool {
+  /**
+   * @brief Kinds of the nodes.
+   */
+  std::vector<FlatExprKind> kinds;
+
+  /**
+   * @brief Payloads of the nodes: the value of an int or bool literal, the
+   * index of a float literal in ``floats``, the symbol id of a variable or a
+   * callee, or the ``Op`` of an operator.
+   */
+  std::vector<std::uint32_t> payloads;
+
+  /**
+   * @brief Numbers of children of the nodes.
+   */
+  std::vector<NodeIndex> arities;
+
+  /**
+   * @brief Indices of the first node in the subtree of each node.
+   */
+  std::vector<NodeIndex> subtree_begins;
+
+  /**
+   * @brief Annotated types of the nodes, or the empty type if not annotated.
+   */
+  std::vector<types::TypeId> types;
+
+  /**
+   * @brief Values of float literals.
+   */
+  std::vector<double> floats;
+
+  /**
+   * @brief Get the number of nodes.
+   * @return The number of nodes in the pool.
+   */
+  std::size_t size() const;
+
+  /**
+   * @brief Get the range of the subtree rooted at a node.
+   * @param index Index of the root.
+   * @return The range of the subtree.
+   */
+  IndexRange subtree(NodeIndex index) const;
+
+  /**
+   * @brief Get the children of a node.
+   * @param index Index of the node.
+   * @return Indices of the roots of the children, in order.
+   */
+  std::vector<NodeIndex> children(NodeIndex index) const;
+};
+
+/**
+ * @brief Kinds of flat statement nodes.
+ */
+enum class FlatStmtKind : std::uint8_t {
+  Let,
+  Assignment,
+  If,
+  While,
+  Break,
+  Continue,
+  Return,
+  Compound
+};
+
+/**
+ * @brief Reference to a statement in the pool of its kind.
+ */
+struct FlatStmtRef {
+  /**
+   * @brief Kind of the statement, which selects the pool.
+   */
+  FlatStmtKind kind;
+
+  /**
+   * @brief Index of the statement in its pool. Unused for ``break`` and
+   * ``continue``.
+   */
+  NodeIndex index;
+};
+
+/**
+ * @brief Flat ``let`` statement.
+ */
+struct FlatLetStmt {
+  /**
+   * @brief Variable name.
+   */
+  util::Symbol var_name;
+
+  /**
+   * @brief Type of the variable.
+   */
+  types::TypeId var_type;
+};
+
+/**
+ * @brief Flat assignment statement.
+ */
+struct FlatAssignmentStmt {
+  /**
+   * @brief Name of the variable to be assigned.
+   */
+  util::Symbol var_name;
+
+  /**
+   * @brief Expression to be assigned.
+   */
+  IndexRange assign_expr;
+};
+
+/**
+ * @brief Flat ``if`` statement.
+ */
+struct FlatIfStmt {
+  /**
+   * @brief Condition expression.
+   */
+  IndexRange condition;
+
+  /**
+   * @brief Statement to be executed if the condition is true.
+   */
+  FlatStmtRef then_stmt;
+
+  /**
+   * @brief Statement to be executed if the condition is false.
+   */
+  FlatStmtRef else_stmt;
+};
+
+/**
+ * @brief Flat ``while`` statement.
+ */
+struct FlatWhileStmt {
+  /**
+   * @brief Condition expression.
+   */
+  IndexRange condition;
+
+  /**
+   * @brief Statement to be executed if the condition is true.
+   */
+  FlatStmtRef body;
+};
+
+/**
+ * @brief Flat ``return`` statement.
+ */
+struct FlatReturnStmt {
+  /**
+   * @brief Expression to be returned.
+   */
+  IndexRange return_expr;
+};
+
+/**
+ * @brief Flat compound statement.
+ */
+struct FlatCompoundStmt {
+  /**
+   * @brief Range of the statements in ``FlatModule::stmt_lists``.
+   */
+  IndexRange stmts;
+};
+
+/**
+ * @brief Flat function declaration.
+ */
+struct FlatFunction {
+  /**
+   * @brief Prototype of the function.
+   */
+  PrototypeNode proto;
+
+  /**
+   * @brief Body of the function, or ``std::nullopt`` for extern functions.
+   */
+  std::optional<FlatStmtRef> func_body;
+};
+
+/**
+ * @brief Module whose nodes are stored in contiguous pools, one per node type,
+ * and refer to each other by 32-bit indices.
+ */
+struct FlatModule {
+  /**
+   * @brief Name of the module.
+   */
+  std::string name;
+
+  /**
+   * @brief Expressions of all statements.
+   */
+  FlatExprPool exprs;
+
+  /**
+   * @brief Pool of ``let`` statements.
+   */
+  std::vector<FlatLetStmt> lets;
+
+  /**
+   * @brief Pool of assignment statements.
+   */
+  std::vector<FlatAssignmentStmt> assignments;
+
+  /**
+   * @brief Pool of ``if`` statements.
+   */
+  std::vector<FlatIfStmt> ifs;
+
+  /**
+   * @brief Pool of ``while`` statements.
+   */
+  std::vector<FlatWhileStmt> whiles;
+
+  /**
+   * @brief Pool of ``return`` statements.
+   */
+  std::vector<FlatReturnStmt> returns;
+
+  /**
+   * @brief Pool of compound statements.
+   */
+  std::vector<FlatCompoundStmt> compounds;
+
+  /**
+   * @brief Statements of compound statements, each stored contiguously.
+   */
+  std::vector<FlatStmtRef> stmt_lists;
+
+  /**
+   * @brief Declared functions, in order.
+   */
+  std::vector<FlatFunction> functions;
+};
+
+/**
+ * @brief Convert a module to the flat representation.
+ * @param module The module to convert.
+ * @return The flat module, which does not refer to ``module``.
+ * @throw std::logic_error If the module has more nodes than fit in
+ * ``NodeIndex``.
+ */
+FlatModule flatten(const Module &module);
+} // namespace stapl::ast
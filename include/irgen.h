@@ -1,13 +1,24 @@
 #pragma once
 
 #include "ast.h"
-
+#include "effects.h"
+#include "flat_ast.h"
+#include "ops.h"
+#include "range.h"
+#include "scope.h"
+#include "symbol.h"
+#include "types.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <ostream>
 #include <string>
-#include <unordered_map>
+#include <utility>
 #include <vector>
 
+#include <llvm/ADT/STLFunctionalExtras.h>
 #include <llvm/ADT/StringRef.h>
 #include <llvm/IR/Function.h>
 #include <llvm/IR/IRBuilder.h>
@@ -21,6 +32,33 @@
  * @brief Classes related to LLVM IR generation.
  */
 namespace stapl::ir {
+/**
+ * @brief How integer division and remainder handle a zero divisor and
+ * ``INT_MIN / -1``.
+ */
+enum class IntDivPolicy : std::uint8_t {
+  /**
+   * @brief Check the operands and trap, unless the ranges of the operands rule
+   * both cases out.
+   */
+  Trap,
+
+  /**
+   * @brief Emit no checks. Both cases are undefined behavior.
+   */
+  Unchecked
+};
+
+/**
+ * @brief Options of IR generation.
+ */
+struct IRGenOptions {
+  /**
+   * @brief Handling of undefined integer division.
+   */
+  IntDivPolicy int_div = IntDivPolicy::Trap;
+};
+
 /**
  * @brief A visitor for generating LLVM IR.
  */
@@ -42,10 +80,20 @@ private:
   std::unique_ptr<llvm::IRBuilder<>> builder;
 
   /**
-   * @brief The current scope's symbols.
+   * @brief Options of IR generation.
    */
-  std::unordered_map<std::string, llvm::AllocaInst *> current_scope_symbols =
-      {};
+  IRGenOptions options;
+
+  /**
+   * @brief LLVM types of the types seen so far, indexed by type id. Types not
+   * looked up yet have ``nullptr``.
+   */
+  std::vector<llvm::Type *> llvm_types;
+
+  /**
+   * @brief Allocations of the variables in scope in the current function.
+   */
+  util::ScopeStack<llvm::AllocaInst *> variables;
 
   /**
    * @brief The cond block of the current loop.
@@ -57,6 +105,16 @@ private:
    */
   llvm::BasicBlock *current_loop_merge = nullptr;
 
+  /**
+   * @brief Ranges of the expressions of the module, if they were analyzed.
+   */
+  const analysis::RangeFacts *range_facts = nullptr;
+
+  /**
+   * @brief Effects of the functions of the module, if they were analyzed.
+   */
+  const analysis::EffectFacts *effect_facts = nullptr;
+
   /**
    * @brief Generate IR for positive prefix operation of ``llvm::Value *``.
    * @param rhs_val The value to negate.
@@ -169,6 +227,139 @@ private:
    */
   llvm::Value *binary_op_ge(llvm::Value *lhs_val, llvm::Value *rhs_val);
 
+  /**
+   * @brief Member function generating IR for a unary operation.
+   */
+  using UnaryBuilder = llvm::Value *(IRGen::*)(llvm::Value *);
+
+  /**
+   * @brief Member function generating IR for a binary operation.
+   */
+  using BinaryBuilder = llvm::Value *(IRGen::*)(llvm::Value *, llvm::Value *);
+
+  /**
+   * @brief Generators of unary operations, indexed by ``ast::Op``. Operators
+   * that are not unary have ``nullptr``.
+   */
+  static const std::array<UnaryBuilder, ast::num_ops> unary_builders;
+
+  /**
+   * @brief Generators of binary operations, indexed by ``ast::Op``. Operators
+   * that are not binary have ``nullptr``.
+   */
+  static const std::array<BinaryBuilder, ast::num_ops> binary_builders;
+
+  /**
+   * @brief Generate IR for a unary operation.
+   * @param op The operator.
+   * @param rhs_val The operand.
+   * @return The result of the operation.
+   */
+  llvm::Value *unary_op(ast::Op op, llvm::Value *rhs_val);
+
+  /**
+   * @brief Generate IR for a binary operation.
+   * @param op The operator.
+   * @param lhs_val The value on LHS.
+   * @param rhs_val The value on RHS.
+   * @param lhs_range Range of the value on LHS, if it is an ``int``.
+   * @param rhs_range Range of the value on RHS, if it is an ``int``.
+   * @return The result of the operation.
+   */
+  llvm::Value *binary_op(ast::Op op, llvm::Value *lhs_val,
+                         llvm::Value *rhs_val,
+                         const analysis::Interval &lhs_range = {},
+                         const analysis::Interval &rhs_range = {});
+
+  /**
+   * @brief Generate a check which traps if an integer division or remainder
+   * has no defined result. Cases ruled out by the ranges are not checked.
+   * @param lhs_val The dividend.
+   * @param rhs_val The divisor.
+   * @param lhs_range Range of the dividend.
+   * @param rhs_range Range of the divisor.
+   */
+  void emit_division_check(llvm::Value *lhs_val, llvm::Value *rhs_val,
+                           const analysis::Interval &lhs_range,
+                           const analysis::Interval &rhs_range);
+
+  /**
+   * @brief Look up the function to call and check the number of arguments.
+   * @param callee The name of the function.
+   * @param arg_count The number of arguments of the call.
+   * @return The function to call.
+   */
+  llvm::Function *get_callee(util::Symbol callee, std::size_t arg_count);
+
+  /**
+   * @brief Generate IR for a ``let`` statement.
+   * @param var_name The name of the variable.
+   * @param var_type The type of the variable.
+   * @throw std::logic_error If the innermost scope declares ``var_name``
+   * already.
+   */
+  void emit_let(util::Symbol var_name, types::TypeId var_type);
+
+  /**
+   * @brief Get the allocation of a variable in scope.
+   * @param name The name of the variable.
+   * @return The allocation of the innermost variable named ``name``.
+   * @throw std::logic_error If no variable named ``name`` is in scope.
+   */
+  llvm::AllocaInst *get_variable(util::Symbol name) const;
+
+  /**
+   * @brief Generate IR for an ``if`` statement.
+   * @param condition Callback generating IR for the condition.
+   * @param then_stmt Callback generating IR for the ``then`` branch.
+   * @param else_stmt Callback generating IR for the ``else`` branch.
+   */
+  void emit_if(llvm::function_ref<llvm::Value *()> condition,
+               llvm::function_ref<void()> then_stmt,
+               llvm::function_ref<void()> else_stmt);
+
+  /**
+   * @brief Generate IR for a ``while`` statement.
+   * @param condition Callback generating IR for the condition.
+   * @param body Callback generating IR for the body.
+   */
+  void emit_while(llvm::function_ref<llvm::Value *()> condition,
+                  llvm::function_ref<void()> body);
+
+  /**
+   * @brief Declare the LLVM function of a prototype, unless a declaration of
+   * the same type exists already.
+   * @param proto The prototype of the function.
+   * @return The declared function, which has no body yet.
+   */
+  llvm::Function *declare_function(const ast::PrototypeNode &proto);
+
+  /**
+   * @brief Generate IR for a function declaration.
+   * @param proto The prototype of the function.
+   * @param body Callback generating IR for the body, or empty for extern
+   * functions.
+   */
+  void emit_function(const ast::PrototypeNode &proto,
+                     llvm::function_ref<void()> body);
+
+  /**
+   * @brief Generate IR for an expression of a flat module in a single pass.
+   * @param exprs The expression pool.
+   * @param range The range of the expression in ``exprs``.
+   * @return The value of the expression.
+   */
+  llvm::Value *codegen_flat_expr(const ast::FlatExprPool &exprs,
+                                 ast::IndexRange range);
+
+  /**
+   * @brief Generate IR for a statement of a flat module.
+   * @param module_node The flat module.
+   * @param stmt The statement.
+   */
+  void codegen_flat_stmt(const ast::FlatModule &module_node,
+                         ast::FlatStmtRef stmt);
+
   /**
    * @brief Create an alloca instruction in the entry block of the function.
    * @param func The function to create the alloca in.
@@ -184,30 +375,111 @@ private:
                                              llvm::Type *type);
 
   /**
-   * @brief Get the LLVM type from a type name.
-   * @param name The name of the type.
+   * @brief Get the LLVM type of a type, caching it for later lookups.
+   * @param type The type.
    * @return The LLVM type.
    */
-  llvm::Type *type_from_typename(const std::string &name);
+  llvm::Type *get_llvm_type(types::TypeId type);
+
+  /**
+   * @brief Set the overflow and exactness flags of an integer instruction from
+   * the ranges of its operands.
+   * @param value The result of the operation. Values other than instructions
+   * which can overflow or be exact are left as they are.
+   * @param flags The flags to set.
+   */
+  void set_wrap_flags(llvm::Value *value, analysis::WrapFlags flags);
+
+  /**
+   * @brief Attach the range of a variable to a load of it.
+   * @param load The load of an ``int`` variable.
+   * @param range The range of the loaded value. Full ranges are not attached.
+   */
+  void set_range_metadata(llvm::LoadInst *load,
+                          const analysis::Interval &range);
+
+  /**
+   * @brief Add the function attributes implied by the effects of a function.
+   * @param func The function.
+   * @param effects The effects of ``func``.
+   */
+  void set_function_attributes(llvm::Function *func,
+                               const analysis::FunctionEffects &effects);
 
 public:
   /**
-   * @brief Default constructor.
+   * @brief Instantiate from options.
+   * @param options Options of IR generation.
+   */
+  explicit IRGen(const IRGenOptions &options = {});
+
+  /**
+   * @brief Use the ranges of the expressions of the module to be generated.
+   * Arithmetic which cannot overflow gets ``nsw`` and ``nuw`` flags, and loads
+   * of ``int`` variables get ``!range`` metadata.
+   * @param facts The ranges, which must outlive code generation.
    */
-  IRGen();
+  void set_range_facts(const analysis::RangeFacts &facts);
 
   /**
-   * @brief Generate IR for a module.
+   * @brief Use the effects of the functions of the module to be generated.
+   * Functions get ``nounwind``, ``norecurse``, ``willreturn`` and memory
+   * attributes where the effects allow.
+   * @param facts The effects, which must outlive code generation.
+   */
+  void set_effect_facts(const analysis::EffectFacts &facts);
+
+  /**
+   * @brief Generate IR for a module. All functions are declared first, so that
+   * they can call functions defined later.
    * @param module_node The module to generate IR for.
    */
   void codegen(ast::Module &module_node);
 
+  /**
+   * @brief Generate IR for a flat module.
+   * @param module_node The flat module to generate IR for.
+   */
+  void codegen(const ast::FlatModule &module_node);
+
   /**
    * @brief Write the generated IR to a stream.
    * @param os The ``std::ostream`` to write to.
    */
   void write_ir(std::ostream &os);
 
+  /**
+   * @brief Write the generated IR as text to a file, through a buffered file
+   * descriptor instead of an ``std::ostream``.
+   * @param path Path of the file to write, or ``-`` for the standard output.
+   * @throw std::logic_error If the file cannot be opened.
+   */
+  void write_ir(const std::string &path);
+
+  /**
+   * @brief Write the generated IR as bitcode to a file. Bitcode is smaller
+   * than text, and faster to write and to read back.
+   * @param path Path of the file to write, or ``-`` for the standard output.
+   * @throw std::logic_error If the file cannot be opened.
+   */
+  void write_bitcode(const std::string &path);
+
+  /**
+   * @brief Get the generated module, for passes which run after IR
+   * generation.
+   * @return The LLVM module.
+   */
+  llvm::Module &get_module();
+
+  /**
+   * @brief Take the generated module and the context owning it, for stages
+   * which outlive the generator, such as the JIT. The generator must not be
+   * used afterwards.
+   * @return The context and the module.
+   */
+  std::pair<std::unique_ptr<llvm::LLVMContext>, std::unique_ptr<llvm::Module>>
+  release_module();
+
   /**
    * @brief Generate IR for integer literal.
    * @param node The node to generate IR for.
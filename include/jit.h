@@ -0,0 +1,197 @@
+#pragma once
+
+#include "object_cache.h"
+#include "optimizer.h"
+#include "types.h"
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <llvm/ExecutionEngine/Orc/LLJIT.h>
+#include <llvm/IR/Function.h>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+#include <llvm/Target/TargetMachine.h>
+
+/**
+ * @brief In-process execution of generated code.
+ */
+namespace stapl::jit {
+/**
+ * @brief Options of the JIT.
+ */
+struct JITOptions {
+  /**
+   * @brief Optimization level of the IR pipeline and of code generation.
+   */
+  opt::OptLevel opt_level = opt::OptLevel::O0;
+
+  /**
+   * @brief Name of the function called by ``JIT::run``.
+   */
+  std::string entry = "main";
+
+  /**
+   * @brief Whether each function is optimized and compiled on its first
+   * call, instead of compiling the whole module before the entry function is
+   * called. Functions are optimized one at a time, so calls are not inlined.
+   */
+  bool lazy = false;
+
+  /**
+   * @brief Number of background threads compiling code, or zero to compile on
+   * the thread which needs the code.
+   */
+  unsigned compile_threads = 0;
+
+  /**
+   * @brief Whether the functions the entry function may call are compiled on
+   * the compile threads before they are first called, when compiling lazily.
+   * At least one compile thread is used if set.
+   */
+  bool speculate = false;
+
+  /**
+   * @brief Directory of the on-disk object cache, or empty for no cache.
+   */
+  std::string cache_dir;
+
+  /**
+   * @brief Maximum total size of the objects in the cache in bytes.
+   */
+  std::uintmax_t cache_size = 512 << 20;
+};
+
+/**
+ * @brief A JIT compiler for the host, which runs the entry function of a
+ * module.
+ *
+ * Modules are optimized as they are compiled, either whole or one function
+ * at a time, and their objects may be cached on disk. Extern functions are
+ * resolved against the symbols of the host process, so functions of the C
+ * library can be called.
+ */
+class JIT {
+private:
+  /**
+   * @brief Options of the JIT.
+   */
+  JITOptions options;
+
+  /**
+   * @brief Cache of compiled objects, or ``nullptr`` if there is none. It is
+   * declared before ``jit``, so that it outlives the compilers using it.
+   */
+  std::unique_ptr<ObjectCache> cache;
+
+  /**
+   * @brief The ORC JIT.
+   */
+  std::unique_ptr<llvm::orc::LLJIT> jit;
+
+  /**
+   * @brief The ORC JIT as a lazy JIT, or ``nullptr`` if it compiles eagerly.
+   */
+  llvm::orc::LLLazyJIT *lazy_jit = nullptr;
+
+  /**
+   * @brief Target machine of the host, which guides optimization.
+   */
+  std::unique_ptr<llvm::TargetMachine> machine;
+
+  /**
+   * @brief Types of the parameters of the entry function.
+   */
+  std::vector<types::TypeId> entry_params;
+
+  /**
+   * @brief Return type of the entry function.
+   */
+  types::TypeId entry_return;
+
+  /**
+   * @brief Names of the defined functions the entry function may call,
+   * directly or not, nearest first.
+   */
+  std::vector<std::string> entry_callees;
+
+  /**
+   * @brief Find the defined functions the entry function may call.
+   * @param entry The entry function.
+   */
+  void find_callees(const llvm::Function &entry);
+
+  /**
+   * @brief Start compiling the functions the entry function may call on the
+   * compile threads, without waiting for them.
+   */
+  void speculate_callees();
+
+  /**
+   * @brief Add a function to a module which calls the entry function with
+   * arguments from an array of 64-bit slots, and returns the result in a
+   * 64-bit slot, so that entry functions of any signature can be called.
+   * @param module The module defining the entry function.
+   * @throw std::logic_error If ``module`` does not define the entry function.
+   */
+  void add_trampoline(llvm::Module &module);
+
+public:
+  /**
+   * @brief Instantiate a JIT for the host.
+   * @param options Options of the JIT.
+   * @throw std::logic_error If the host is not supported.
+   */
+  explicit JIT(const JITOptions &options = {});
+
+  /**
+   * @brief Deleted copy constructor, as the compilers of ``jit`` hold
+   * ``this``.
+   */
+  JIT(const JIT &) = delete;
+
+  /**
+   * @brief Deleted move constructor, as the compilers of ``jit`` hold
+   * ``this``.
+   */
+  JIT(JIT &&) = delete;
+
+  /**
+   * @brief Deleted copy assignment operator, as the compilers of ``jit`` hold
+   * ``this``.
+   */
+  JIT &operator=(const JIT &) = delete;
+
+  /**
+   * @brief Deleted move assignment operator, as the compilers of ``jit`` hold
+   * ``this``.
+   */
+  JIT &operator=(JIT &&) = delete;
+
+  /**
+   * @brief Add the module defining the entry function. Its functions are
+   * compiled when they are first looked up, or first called if compiling
+   * lazily.
+   * @param context The context owning ``module``.
+   * @param module The module.
+   * @throw std::logic_error If ``module`` does not define the entry function,
+   * or defines a symbol which was already added.
+   */
+  void add_module(std::unique_ptr<llvm::LLVMContext> context,
+                  std::unique_ptr<llvm::Module> module);
+
+  /**
+   * @brief Call the entry function.
+   * @param args The arguments as text, such as ``42``, ``1.5`` or ``true``,
+   * converted to the types of the parameters.
+   * @return The result as text, or ``std::nullopt`` if the entry function
+   * returns ``void``.
+   * @throw std::logic_error If the arguments do not match the parameters, or
+   * a symbol cannot be resolved.
+   */
+  std::optional<std::string> run(const std::vector<std::string> &args);
+};
+} // namespace stapl::jit
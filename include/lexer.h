@@ -1,11 +1,15 @@
 #pragma once
 
+#include "ops.h"
+#include "scan.h"
+
+#include <cstddef>
+#include <cstdint>
 #include <istream>
-#include <map>
-#include <set>
-#include <streambuf>
 #include <string>
-#include <utility>
+#include <string_view>
+#include <variant>
+#include <vector>
 
 namespace stapl::parsing {
 /**
@@ -98,62 +102,240 @@ enum class TokenKind {
   Misc,
 };
 
+/**
+ * @brief Value of a token, converted while lexing.
+ *
+ * ``Int`` tokens hold a ``std::int64_t``, ``Float`` tokens hold a ``double``
+ * and ``Op`` tokens of operators hold an ``ast::Op``. Other tokens, including
+ * ``=``, hold ``std::monostate``.
+ */
+using TokenValue =
+    std::variant<std::monostate, std::int64_t, double, ast::Op>;
+
 /**
  * @brief Lexed token object.
+ *
+ * The text of a token is a view into the code being lexed, so lexing does not
+ * allocate. The code must outlive the tokens lexed from it.
  */
-typedef std::pair<TokenKind, std::string> Token;
+struct Token {
+  /**
+   * @brief Kind of the token.
+   */
+  TokenKind kind;
+
+  /**
+   * @brief Text of the token, viewing into the lexed code.
+   */
+  std::string_view text;
+
+  /**
+   * @brief Value of the token if it is a literal or an operator.
+   */
+  TokenValue value;
+
+  /**
+   * @brief Default constructor.
+   */
+  Token() = default;
+
+  /**
+   * @brief Instantiate from token kind, text and value.
+   * @param kind Kind of the token.
+   * @param text Text of the token.
+   * @param value Value of the token if it is a literal or an operator.
+   */
+  Token(TokenKind kind, std::string_view text, TokenValue value = {});
+
+  /**
+   * @brief Comparision operator overload.
+   * @param rhs ``Token`` on the RHS.
+   * @return Whether ``this`` and ``rhs`` have the same kind, text and value.
+   */
+  bool operator==(const Token &rhs) const = default;
+};
 
 /**
  * @brief Lexer for stapl.
+ *
+ * The lexer either borrows the whole code, or pulls it in fixed-size chunks
+ * from a ``std::istream``. In the latter case only the current chunk and the
+ * token being lexed are held in memory, and the text of a token is valid only
+ * until the next call to ``get_token``.
  */
 class Lexer {
 private:
   /**
-   * @brief Code string that is currently lexed.
+   * @brief Code that is currently lexed. When lexing from a stream, this views
+   * into ``buffer``.
    */
-  std::string code;
+  std::string_view code;
 
   /**
-   * @brief Identifier that is currently lexed.
+   * @brief Position of the character currently looked at.
    */
-  std::string identifier;
+  std::size_t pos;
 
   /**
-   * @brief Operator that is currently lexed.
+   * @brief Position in ``code`` where the token being lexed starts.
    */
-  std::string op;
+  std::size_t token_start;
 
   /**
-   * @brief Iterator of currently lexed code.
+   * @brief Stream to pull chunks of code from, or ``nullptr`` if the lexer
+   * borrows the whole code.
    */
-  std::string::iterator it;
+  std::istream *input;
 
   /**
-   * @brief DFA table for parsing operators.
+   * @brief Number of bytes read from ``input`` at a time.
    */
-  std::map<int, std::set<int>> operator_dfa;
+  std::size_t chunk_size;
 
   /**
-   * @brief Mapping for recognizing keywords.
+   * @brief Buffer holding the code read from ``input``.
    */
-  std::map<std::string, TokenKind> token_table;
+  std::string buffer;
 
   /**
-   * @brief Last character seen.
+   * @brief Read the next chunk from ``input``, keeping the part of the buffer
+   * from ``token_start``.
+   * @return Whether more code was read.
    */
-  int last_char;
+  bool refill();
+
+  /**
+   * @brief Move ``pos`` past a run of characters, refilling the buffer when
+   * the run reaches its end.
+   * @param scan_fn Scanning function returning the end of the run.
+   * @param keep Whether the run belongs to the token, so it has to be kept in
+   * the buffer.
+   */
+  void advance(std::size_t (*scan_fn)(std::string_view, std::size_t,
+                                      scan::Isa),
+               bool keep);
+
+  /**
+   * @brief Return the character currently looked at without consuming it.
+   * @return The current character, or ``'\0'`` past the end of the code.
+   */
+  int peek();
 
 public:
   /**
    * @brief Constructor for lexer.
-   * @param code Code string to be lexed.
+   * @param code Code to be lexed. It must outlive the lexer and the tokens.
+   */
+  Lexer(std::string_view code);
+
+  /**
+   * @brief Constructor for lexer reading the code from a stream.
+   * @param input Stream to read the code from. It must outlive the lexer.
+   * @param chunk_size Number of bytes to read from ``input`` at a time.
+   */
+  Lexer(std::istream &input, std::size_t chunk_size = 1 << 16);
+
+  /**
+   * @brief Deleted copy constructor, as ``code`` may view into ``buffer``.
+   */
+  Lexer(const Lexer &) = delete;
+
+  /**
+   * @brief Deleted copy assignment operator, as ``code`` may view into
+   * ``buffer``.
    */
-  Lexer(std::string code);
+  Lexer &operator=(const Lexer &) = delete;
 
   /**
    * @brief Return a single lexed token.
    * @return A lexed token.
+   * @throw std::logic_error If a number literal is malformed or out of range.
    */
   Token get_token();
 };
+
+/**
+ * @brief Lex the whole code.
+ * @param code Code to be lexed.
+ * @return Tokens of ``code``, ending with an ``Eof`` token.
+ * @throw std::logic_error If a number literal is malformed or out of range.
+ */
+std::vector<Token> tokenize(std::string_view code);
+
+/**
+ * @brief Lex the whole code on multiple threads.
+ *
+ * No token spans a line, so the code is split before lines starting with
+ * ``def`` or ``extern`` into at most ``jobs`` chunks of similar size, which are
+ * lexed concurrently. The result is the same as that of ``tokenize``.
+ * @param code Code to be lexed.
+ * @param jobs Maximum number of threads to use.
+ * @return Tokens of ``code``, ending with an ``Eof`` token.
+ * @throw std::logic_error If a number literal is malformed or out of range.
+ * When several chunks fail, the error of the first one is thrown.
+ */
+std::vector<Token> tokenize_parallel(std::string_view code, unsigned jobs);
+
+/**
+ * @brief An edit replacing a range of code.
+ */
+struct TextEdit {
+  /**
+   * @brief Offset of the replaced range in the code before the edit.
+   */
+  std::size_t offset;
+
+  /**
+   * @brief Length of the replaced range.
+   */
+  std::size_t length;
+
+  /**
+   * @brief Text replacing the range.
+   */
+  std::string_view replacement;
+};
+
+/**
+ * @brief Range of token indices.
+ */
+struct TokenRange {
+  /**
+   * @brief Index of the first token in the range.
+   */
+  std::size_t begin;
+
+  /**
+   * @brief Index past the last token in the range.
+   */
+  std::size_t end;
+
+  /**
+   * @brief Comparision operator overload.
+   * @param rhs ``TokenRange`` on the RHS.
+   * @return Whether ``this`` and ``rhs`` are the same range.
+   */
+  bool operator==(const TokenRange &rhs) const = default;
+};
+
+/**
+ * @brief Update the tokens of edited code, re-lexing only around the edit.
+ *
+ * Lexing restarts at the start of the line containing the edit, as no token
+ * spans a line, and stops as soon as a token after the edit starts where a
+ * token started before the edit. The result is the same as that of
+ * ``tokenize(new_code)``.
+ * @param tokens Tokens of ``old_code``, as returned by ``tokenize``. They are
+ * updated to view into ``new_code``, and are left untouched if an exception is
+ * thrown.
+ * @param old_code Code before the edit.
+ * @param new_code Code after the edit.
+ * @param edit Edit turning ``old_code`` into ``new_code``.
+ * @return Range of the re-lexed tokens in the updated ``tokens``. The other
+ * tokens are the same as before, although they may have moved.
+ * @throw std::logic_error If the edit does not fit the code, or if a number
+ * literal is malformed or out of range.
+ */
+TokenRange relex(std::vector<Token> &tokens, std::string_view old_code,
+                 std::string_view new_code, const TextEdit &edit);
 } // namespace stapl::parsing
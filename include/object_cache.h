@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include <llvm/ExecutionEngine/ObjectCache.h>
+#include <llvm/IR/Module.h>
+#include <llvm/Support/MemoryBuffer.h>
+
+namespace stapl::jit {
+/**
+ * @brief Cache of compiled objects in a directory, which outlives the process.
+ *
+ * An object is stored under a hash of the bitcode of the optimized module it
+ * was compiled from and of a tag naming the target, so that a module compiled
+ * again for the same target loads its object instead of running code
+ * generation. Least recently used objects are removed when the objects take
+ * more space than allowed. Failures to read or write the cache are not errors;
+ * the module is just compiled.
+ */
+class ObjectCache : public llvm::ObjectCache {
+private:
+  /**
+   * @brief Directory holding the objects.
+   */
+  std::filesystem::path directory;
+
+  /**
+   * @brief Maximum total size of the objects in bytes.
+   */
+  std::uintmax_t max_size;
+
+  /**
+   * @brief Target triple, CPU, features and optimization level, which are
+   * hashed along with each module.
+   */
+  std::string tag;
+
+  /**
+   * @brief Mutex guarding ``pending_keys``, ``total_size`` and eviction, as
+   * modules may be compiled on several threads.
+   */
+  std::mutex mutex;
+
+  /**
+   * @brief Total size of the objects in bytes, as of the last eviction plus
+   * the objects stored since. Other processes sharing the directory make it
+   * approximate.
+   */
+  std::uintmax_t total_size = 0;
+
+  /**
+   * @brief Keys of the modules which missed the cache and are being compiled.
+   */
+  std::unordered_map<const llvm::Module *, std::string> pending_keys;
+
+  /**
+   * @brief Compute the key of a module.
+   * @param module The module.
+   * @return Hex digest of the bitcode of ``module`` and ``tag``.
+   */
+  std::string key(const llvm::Module &module) const;
+
+  /**
+   * @brief Get the path of the object of a key.
+   * @param key The key.
+   * @return The path of the object in ``directory``.
+   */
+  std::filesystem::path object_path(const std::string &key) const;
+
+  /**
+   * @brief Remove the least recently used objects until the objects fit in
+   * ``max_size``, and recount ``total_size``. Reading an object updates its
+   * modification time, which orders the objects by use.
+   */
+  void evict();
+
+public:
+  /**
+   * @brief Instantiate a cache in a directory, which is created if missing.
+   * @param directory The directory holding the objects.
+   * @param max_size Maximum total size of the objects in bytes.
+   * @param tag Description of the target and the optimization level, which
+   * must differ between caches whose objects are not interchangeable.
+   * @throw std::logic_error If the directory cannot be created.
+   */
+  ObjectCache(std::filesystem::path directory, std::uintmax_t max_size,
+              std::string tag);
+
+  /**
+   * @brief Store the object compiled from a module which missed the cache.
+   * @param module The module.
+   * @param object The object.
+   */
+  void notifyObjectCompiled(const llvm::Module *module,
+                            llvm::MemoryBufferRef object) override;
+
+  /**
+   * @brief Look the object of a module up.
+   * @param module The module.
+   * @return The cached object, or ``nullptr`` if the module must be compiled.
+   */
+  std::unique_ptr<llvm::MemoryBuffer>
+  getObject(const llvm::Module *module) override;
+};
+} // namespace stapl::jit
@@ -0,0 +1,172 @@
+#pragma once
+
+#include "types.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+namespace stapl::ast {
+/**
+ * @brief Operators of unary and binary expressions.
+ *
+ * The lexer assigns the operator of a token once, and later phases look up
+ * its properties in the tables below, indexed by the operator.
+ */
+enum class Op : std::uint8_t {
+  Add,
+  Sub,
+  Mul,
+  Div,
+  Mod,
+  Eq,
+  Ne,
+  Lt,
+  Gt,
+  Le,
+  Ge,
+  Not
+};
+
+/**
+ * @brief Number of operators.
+ */
+constexpr std::size_t num_ops = static_cast<std::size_t>(Op::Not) + 1;
+
+/**
+ * @brief Texts of the operators, indexed by ``Op``.
+ */
+constexpr std::array<std::string_view, num_ops> op_texts = {
+    "+", "-", "*", "/", "%", "==", "!=", "<", ">", "<=", ">=", "!"};
+
+/**
+ * @brief Precedences of the operators as binary operators, indexed by ``Op``.
+ * Operators that are not binary have precedence -1.
+ */
+constexpr std::array<int, num_ops> binary_precs = {20, 20, 40, 40, 40, 10,
+                                                   10, 10, 10, 10, 10, -1};
+
+/**
+ * @brief Whether the operators can be used as unary operators, indexed by
+ * ``Op``.
+ */
+constexpr std::array<bool, num_ops> unary_ops = {
+    true, true, false, false, false, false, false, false, false, false, false,
+    true};
+
+/**
+ * @brief A type signature of an operator.
+ */
+struct OpSignature {
+  /**
+   * @brief Number of operands.
+   */
+  std::size_t arity;
+
+  /**
+   * @brief Types of the operands.
+   */
+  std::array<types::TypeId, 2> arg_types;
+
+  /**
+   * @brief Type of the result.
+   */
+  types::TypeId return_type;
+};
+
+/**
+ * @brief Maximum number of signatures of an operator.
+ */
+constexpr std::size_t max_op_signatures = 4;
+
+/**
+ * @brief Type signatures of the operators, indexed by ``Op``. Unused entries
+ * have arity 0.
+ */
+constexpr auto op_signatures = [] {
+  using types::bool_type, types::float_type, types::int_type;
+  constexpr OpSignature int_unary = {1, {int_type}, int_type},
+                        float_unary = {1, {float_type}, float_type},
+                        int_arith = {2, {int_type, int_type}, int_type},
+                        float_arith = {2, {float_type, float_type}, float_type},
+                        int_cmp = {2, {int_type, int_type}, bool_type},
+                        float_cmp = {2, {float_type, float_type}, bool_type},
+                        bool_cmp = {2, {bool_type, bool_type}, bool_type};
+  std::array<std::array<OpSignature, max_op_signatures>, num_ops> table{};
+  for (auto op : {Op::Add, Op::Sub})
+    table[static_cast<std::size_t>(op)] = {int_arith, float_arith, int_unary,
+                                           float_unary};
+  for (auto op : {Op::Mul, Op::Div})
+    table[static_cast<std::size_t>(op)] = {int_arith, float_arith};
+  table[static_cast<std::size_t>(Op::Mod)] = {int_arith};
+  table[static_cast<std::size_t>(Op::Not)] = {{{1, {bool_type}, bool_type}}};
+  for (auto op : {Op::Eq, Op::Ne, Op::Lt, Op::Gt, Op::Le, Op::Ge})
+    table[static_cast<std::size_t>(op)] = {int_cmp, float_cmp, bool_cmp};
+  return table;
+}();
+
+/**
+ * @brief Get the operator of a text.
+ * @param text The text of the operator.
+ * @return The operator, or ``std::nullopt`` if ``text`` is not an operator.
+ */
+constexpr std::optional<Op> op_from_text(std::string_view text) {
+  for (std::size_t i = 0; i < num_ops; i++)
+    if (op_texts[i] == text)
+      return static_cast<Op>(i);
+  return std::nullopt;
+}
+
+/**
+ * @brief Get the text of an operator.
+ * @param op The operator.
+ * @return The text of ``op``.
+ */
+constexpr std::string_view op_text(Op op) {
+  return op_texts[static_cast<std::size_t>(op)];
+}
+
+/**
+ * @brief Get the precedence of an operator as a binary operator.
+ * @param op The operator.
+ * @return The precedence of ``op``, or -1 if it is not a binary operator.
+ */
+constexpr int binary_prec(Op op) {
+  return binary_precs[static_cast<std::size_t>(op)];
+}
+
+/**
+ * @brief Get whether an operator can be used as a unary operator.
+ * @param op The operator.
+ * @return Whether ``op`` is a unary operator.
+ */
+constexpr bool is_unary_op(Op op) {
+  return unary_ops[static_cast<std::size_t>(op)];
+}
+
+/**
+ * @brief Get the result type of an operator applied to operands.
+ * @param op The operator.
+ * @param arity The number of operands, which is 1 or 2.
+ * @param arg_types The types of the operands.
+ * @return The type of the result, or ``std::nullopt`` if no signature of ``op``
+ * matches.
+ */
+constexpr std::optional<types::TypeId>
+op_return_type(Op op, std::size_t arity,
+               const std::array<types::TypeId, 2> &arg_types) {
+  for (const auto &signature : op_signatures[static_cast<std::size_t>(op)])
+    if (signature.arity == arity && signature.arg_types[0] == arg_types[0] &&
+        (arity == 1 || signature.arg_types[1] == arg_types[1]))
+      return signature.return_type;
+  return std::nullopt;
+}
+
+static_assert(op_from_text("<=") == Op::Le && op_text(Op::Ne) == "!=");
+static_assert(op_return_type(Op::Sub, 1, {types::float_type}) ==
+              types::float_type);
+static_assert(
+    !op_return_type(Op::Mod, 2, {types::float_type, types::float_type}));
+} // namespace stapl::ast
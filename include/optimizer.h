@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+#include <llvm/IR/Module.h>
+#include <llvm/Target/TargetMachine.h>
+
+/**
+ * @brief Optimization of generated LLVM IR.
+ */
+namespace stapl::opt {
+/**
+ * @brief Optimization levels of the default pipelines.
+ */
+enum class OptLevel : std::uint8_t {
+  /**
+   * @brief No optimization, only passes required for correctness.
+   */
+  O0,
+
+  /**
+   * @brief Optimizations which are fast to run.
+   */
+  O1,
+
+  /**
+   * @brief Most optimizations, without ones trading size for speed.
+   */
+  O2,
+
+  /**
+   * @brief All optimizations, including ones which grow the code.
+   */
+  O3,
+
+  /**
+   * @brief Optimizations of ``O2`` which do not grow the code.
+   */
+  Os
+};
+
+/**
+ * @brief Parse an optimization level.
+ * @param text The level as given to ``-O``, such as ``2`` or ``s``.
+ * @return The optimization level, or ``std::nullopt`` if ``text`` is not a
+ * level.
+ */
+std::optional<OptLevel> parse_opt_level(std::string_view text);
+
+/**
+ * @brief Run the default pipeline of an optimization level on a module.
+ * @param module The module to optimize.
+ * @param level The optimization level.
+ * @param machine Target machine whose cost model guides the passes, or
+ * ``nullptr`` to optimize without a target.
+ */
+void optimize_module(llvm::Module &module, OptLevel level,
+                     llvm::TargetMachine *machine = nullptr);
+
+/**
+ * @brief Run a custom pipeline on a module.
+ * @param module The module to optimize.
+ * @param pipeline The pipeline in the syntax of ``opt -passes``, such as
+ * ``function(mem2reg,instcombine)``.
+ * @param machine Target machine whose cost model guides the passes, or
+ * ``nullptr`` to optimize without a target.
+ * @throw std::logic_error If ``pipeline`` cannot be parsed.
+ */
+void run_passes(llvm::Module &module, std::string_view pipeline,
+                llvm::TargetMachine *machine = nullptr);
+} // namespace stapl::opt
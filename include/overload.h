@@ -0,0 +1,124 @@
+#pragma once
+
+#include "symbol.h"
+#include "types.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace stapl::types {
+/**
+ * @brief Overload sets of functions, indexed by name and argument types.
+ *
+ * Overloads are stored in an open-addressing hash table keyed by the hash of
+ * the function name and the argument types, so resolving a call is a single
+ * probe sequence and never allocates. The argument types of all overloads are
+ * stored contiguously in one pool.
+ */
+class OverloadTable {
+private:
+  /**
+   * @brief A registered overload.
+   */
+  struct Overload {
+    /**
+     * @brief Name of the function.
+     */
+    util::Symbol name;
+
+    /**
+     * @brief Index of the first argument type in ``arg_type_pool``.
+     */
+    std::uint32_t args_begin;
+
+    /**
+     * @brief Number of arguments.
+     */
+    std::uint32_t arity;
+
+    /**
+     * @brief Return type of the overload.
+     */
+    TypeId return_type;
+
+    /**
+     * @brief Hash of the name and the argument types.
+     */
+    std::size_t hash;
+  };
+
+  /**
+   * @brief Argument types of all overloads.
+   */
+  std::vector<TypeId> arg_type_pool;
+
+  /**
+   * @brief Registered overloads, in order of registration.
+   */
+  std::vector<Overload> overloads;
+
+  /**
+   * @brief Hash table of overloads. Each slot holds one more than the index of
+   * an overload, or 0 if the slot is empty. The size is zero or a power of
+   * two.
+   */
+  std::vector<std::uint32_t> slots;
+
+  /**
+   * @brief Hash a function name and argument types.
+   * @param name The name of the function.
+   * @param arg_types The types of the arguments.
+   * @return The hash of the key.
+   */
+  static std::size_t hash_key(util::Symbol name,
+                              std::span<const TypeId> arg_types);
+
+  /**
+   * @brief Find the slot of a key.
+   * @param name The name of the function.
+   * @param arg_types The types of the arguments.
+   * @param hash The hash of the key.
+   * @return The index of the slot holding the overload of the key, or of the
+   * empty slot where it would be inserted.
+   */
+  std::size_t find_slot(util::Symbol name, std::span<const TypeId> arg_types,
+                        std::size_t hash) const;
+
+  /**
+   * @brief Double the number of slots and reinsert all overloads.
+   */
+  void grow();
+
+public:
+  /**
+   * @brief Register an overload of a function.
+   * @param name The name of the function.
+   * @param arg_types The types of the arguments.
+   * @param return_type The return type.
+   * @throw std::logic_error If an overload with the same argument types is
+   * already registered, either with the same return type (a duplicate) or with
+   * another one (an ambiguous overload).
+   */
+  void add(util::Symbol name, std::span<const TypeId> arg_types,
+           TypeId return_type);
+
+  /**
+   * @brief Resolve a call of a function.
+   * @param name The name of the function.
+   * @param arg_types The types of the arguments.
+   * @return The return type of the matching overload, or ``std::nullopt`` if
+   * there is none.
+   */
+  std::optional<TypeId> find(util::Symbol name,
+                             std::span<const TypeId> arg_types) const;
+
+  /**
+   * @brief Get the number of registered overloads.
+   * @return The number of overloads of all functions.
+   */
+  std::size_t size() const;
+};
+} // namespace stapl::types
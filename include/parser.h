@@ -2,11 +2,14 @@
 
 #include "ast.h"
 #include "lexer.h"
+#include "token_buffer.h"
 
-#include <map>
+#include <cstddef>
+#include <istream>
 #include <memory>
-#include <streambuf>
+#include <optional>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 
@@ -25,10 +28,37 @@ namespace stapl::parsing {
 class Parser {
 private:
   /**
-   * @brief ``Lexer`` object for getting tokens.
+   * @brief ``Lexer`` object for getting tokens when parsing from a stream.
    */
   Lexer lexer;
 
+  /**
+   * @brief Whether the tokens come from ``lexer`` instead of ``tokens``.
+   */
+  bool streaming;
+
+  /**
+   * @brief Tokens of the whole code, used unless ``streaming``.
+   */
+  TokenBuffer tokens;
+
+  /**
+   * @brief Index of ``current_token`` in ``tokens``.
+   */
+  std::size_t token_index = 0;
+
+  /**
+   * @brief Token after ``current_token`` that has been lexed ahead, when
+   * ``streaming``.
+   */
+  std::optional<Token> lookahead;
+
+  /**
+   * @brief Copy of the text of ``current_token``, which is overwritten by the
+   * lexer when lexing ahead.
+   */
+  std::string current_text;
+
   /**
    * @brief Currently parsing token.
    */
@@ -40,16 +70,13 @@ private:
   Token next_token();
 
   /**
-   * @brief Precedence table for binary operators.
-   */
-  std::map<std::string, int> binop_prec = {
-      {"<", 10}, {"<=", 10}, {">", 10}, {">=", 10}, {"==", 10}, {"!=", 10},
-      {"+", 20}, {"-", 20},  {"*", 40}, {"/", 40},  {"%", 40}};
-
-  /**
-   * @brief Set of unary operators.
+   * @brief Look at a token after ``current_token`` without consuming it.
+   * @param n How many tokens after ``current_token`` to look at.
+   * @return The ``n``-th token after ``current_token``, or the ``Eof`` token if
+   * there are not as many tokens.
+   * @throw std::logic_error If ``n`` is larger than 1 when ``streaming``.
    */
-  std::set<std::string> unary_ops = {"+", "-", "!"};
+  Token peek(std::size_t n = 1);
 
   /**
    * @brief Get precedence of ``current_token``.
@@ -59,14 +86,29 @@ private:
 
 public:
   /**
-   * @brief Constructor for parser.
-   * @param code Code string to be parsed.
+   * @brief Constructor for parser, which lexes the whole code into a
+   * ``TokenBuffer``.
+   * @param code Code to be parsed. It must outlive the parser.
+   */
+  Parser(std::string_view code);
+
+  /**
+   * @brief Constructor for parser reading the code from a stream. Only one
+   * token of lookahead is available in this mode.
+   * @param input Stream to read the code from. It must outlive the parser.
+   */
+  Parser(std::istream &input);
+
+  /**
+   * @brief Constructor for parser taking tokens lexed in advance.
+   * @param tokens Tokens to be parsed, ending with an ``Eof`` token.
    */
-  Parser(std::string code);
+  Parser(TokenBuffer tokens);
 
   /**
    * @brief Parse integer literals.
    * @return A parsed integer literal.
+   * @throw std::logic_error If the literal does not fit in ``int``.
    */
   ast::LiteralExprNode<int> parse_int();
 
@@ -0,0 +1,159 @@
+#pragma once
+
+#include "ast.h"
+#include "flat_ast.h"
+#include "ops.h"
+
+#include <cstdint>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+namespace stapl::analysis {
+/**
+ * @brief Closed interval of values an ``int`` expression may take.
+ *
+ * Bounds are stored in 64 bits, so that the bounds of sums and products of two
+ * ``int`` intervals are exact. An interval is never empty; unreachable code is
+ * tracked separately.
+ */
+struct Interval {
+  /**
+   * @brief Lower bound, inclusive.
+   */
+  std::int64_t lo = std::numeric_limits<std::int32_t>::min();
+
+  /**
+   * @brief Upper bound, inclusive.
+   */
+  std::int64_t hi = std::numeric_limits<std::int32_t>::max();
+
+  /**
+   * @brief Check if the interval holds every ``int``.
+   * @return Whether nothing is known about the value.
+   */
+  bool is_full() const;
+
+  /**
+   * @brief Check if the interval holds a value.
+   * @param value The value to check.
+   * @return Whether ``value`` is in the interval.
+   */
+  bool contains(std::int64_t value) const;
+
+  /**
+   * @brief Get the smallest interval holding both intervals.
+   * @param rhs ``Interval`` to join with.
+   * @return The union hull of ``this`` and ``rhs``.
+   */
+  Interval join(const Interval &rhs) const;
+
+  /**
+   * @brief Comparision operator overload.
+   * @param rhs ``Interval`` on the RHS.
+   * @return Whether ``this`` and ``rhs`` have the same bounds.
+   */
+  bool operator==(const Interval &rhs) const = default;
+};
+
+/**
+ * @brief Overflow and exactness flags an integer instruction may carry.
+ */
+struct WrapFlags {
+  /**
+   * @brief Whether the operation never overflows as a signed operation.
+   */
+  bool nsw = false;
+
+  /**
+   * @brief Whether the operation never overflows as an unsigned operation.
+   */
+  bool nuw = false;
+
+  /**
+   * @brief Whether the division never has a remainder.
+   */
+  bool exact = false;
+};
+
+/**
+ * @brief Compute the overflow and exactness flags of a 32-bit integer
+ * operation.
+ *
+ * Intervals carry no divisibility facts, so a division is only proven exact
+ * when the divisor is 1 or -1, or both operands are constants.
+ * @param op The operator, of which only ``Add``, ``Sub`` and ``Mul`` can carry
+ * overflow flags, and only ``Div`` can be exact.
+ * @param lhs Range of the LHS operand.
+ * @param rhs Range of the RHS operand.
+ * @return The flags which hold for every pair of operands in the ranges.
+ */
+WrapFlags wrap_flags(ast::Op op, const Interval &lhs, const Interval &rhs);
+
+/**
+ * @brief Check if a 32-bit signed division or remainder may have no defined
+ * result, which is when the divisor is zero or the quotient overflows.
+ * @param lhs Range of the dividend.
+ * @param rhs Range of the divisor.
+ * @return Whether any pair of operands in the ranges has no defined result.
+ */
+bool division_may_trap(const Interval &lhs, const Interval &rhs);
+
+/**
+ * @brief Get the key of an expression node in ``RangeFacts::ranges``.
+ * @param expr The expression node.
+ * @return The address of the node, which is stable as long as the AST is not
+ * moved.
+ */
+const void *expr_key(const ast::ExprNode &expr);
+
+/**
+ * @brief Ranges of the ``int`` expressions of a module.
+ *
+ * An expression which is not recorded, or which is not of type ``int``, has
+ * the full range.
+ */
+struct RangeFacts {
+  /**
+   * @brief Ranges of the expressions of a tree AST, keyed by ``expr_key``.
+   */
+  std::unordered_map<const void *, Interval> ranges;
+
+  /**
+   * @brief Ranges of the expressions of a flat AST, indexed by node.
+   */
+  std::vector<Interval> flat_ranges;
+
+  /**
+   * @brief Get the range of an expression of a tree AST.
+   * @param key The key of the expression, from ``expr_key``.
+   * @return The range of the expression.
+   */
+  Interval range(const void *key) const;
+
+  /**
+   * @brief Get the range of an expression of a flat AST.
+   * @param index The index of the expression node.
+   * @return The range of the expression.
+   */
+  Interval flat_range(ast::NodeIndex index) const;
+};
+
+/**
+ * @brief Compute the ranges of the ``int`` expressions of a module.
+ *
+ * Functions are abstractly interpreted over intervals. Branch conditions which
+ * compare a variable narrow its range on each side of the branch, and loops
+ * are iterated to a fixpoint with widening. The module must be type annotated.
+ * @param module The annotated module.
+ * @return The ranges, which hold on every execution of each expression.
+ */
+RangeFacts analyze_ranges(const ast::Module &module);
+
+/**
+ * @brief Compute the ranges of the ``int`` expressions of a flat module.
+ * @param module The annotated flat module.
+ * @return The ranges, which hold on every execution of each expression.
+ */
+RangeFacts analyze_ranges(const ast::FlatModule &module);
+} // namespace stapl::analysis
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+
+/**
+ * @brief Vectorized character scanning used by the lexer.
+ *
+ * Each function starts at ``pos`` in ``code`` and returns the position of the
+ * first character that ends the run being scanned, or ``code.size()`` if the
+ * run reaches the end of ``code``. The character classes match the ones of
+ * ``std::isspace``, ``std::isalnum`` and ``std::isdigit`` in the "C" locale.
+ */
+namespace stapl::parsing::scan {
+/**
+ * @brief Instruction sets that scanning can be done with.
+ */
+enum class Isa {
+  /**
+   * @brief Portable one-character-at-a-time scanning.
+   */
+  Scalar,
+
+  /**
+   * @brief 16 characters at a time with SSE2.
+   */
+  SSE2,
+
+  /**
+   * @brief 32 characters at a time with AVX2.
+   */
+  AVX2,
+};
+
+/**
+ * @brief Return the fastest instruction set supported by the running CPU.
+ * @return The detected instruction set. Detection is done once per process.
+ */
+Isa detected_isa();
+
+/**
+ * @brief Check whether scanning with an instruction set is possible.
+ * @param isa The instruction set to check.
+ * @return Whether ``isa`` is compiled in and supported by the running CPU.
+ */
+bool isa_supported(Isa isa);
+
+/**
+ * @brief Skip whitespace characters.
+ * @param code Code to scan.
+ * @param pos Position to start scanning from.
+ * @param isa Instruction set to scan with.
+ * @return Position of the first non-whitespace character.
+ */
+std::size_t skip_whitespace(std::string_view code, std::size_t pos,
+                            Isa isa = detected_isa());
+
+/**
+ * @brief Skip characters that can continue an identifier (``[A-Za-z0-9_]``).
+ * @param code Code to scan.
+ * @param pos Position to start scanning from.
+ * @param isa Instruction set to scan with.
+ * @return Position of the first character that can't be in an identifier.
+ */
+std::size_t skip_identifier(std::string_view code, std::size_t pos,
+                            Isa isa = detected_isa());
+
+/**
+ * @brief Skip characters that can be in a number literal (``[0-9.]``).
+ * @param code Code to scan.
+ * @param pos Position to start scanning from.
+ * @param isa Instruction set to scan with.
+ * @return Position of the first character that can't be in a number.
+ */
+std::size_t skip_number(std::string_view code, std::size_t pos,
+                        Isa isa = detected_isa());
+
+/**
+ * @brief Find the end of the line, which terminates a ``#`` comment.
+ * @param code Code to scan.
+ * @param pos Position to start scanning from.
+ * @param isa Instruction set to scan with.
+ * @return Position of the first ``'\n'``, ``'\r'`` or ``'\0'``.
+ */
+std::size_t find_line_end(std::string_view code, std::size_t pos,
+                          Isa isa = detected_isa());
+} // namespace stapl::parsing::scan
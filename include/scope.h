@@ -0,0 +1,150 @@
+#pragma once
+
+#include "symbol.h"
+
+#include <cstddef>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace stapl::util {
+/**
+ * @brief Stack of lexical scopes binding symbols to values.
+ *
+ * Bindings of all open scopes are stored contiguously, innermost last, and
+ * each scope remembers where its bindings begin. Opening and closing a scope
+ * is O(1), and a lookup scans the bindings from the innermost scope outwards,
+ * so inner bindings shadow outer ones. The stack starts with one open scope,
+ * which cannot be closed.
+ * @tparam T Type of the bound values.
+ */
+template <typename T> class ScopeStack {
+private:
+  /**
+   * @brief A binding of a symbol.
+   */
+  struct Binding {
+    /**
+     * @brief The bound symbol.
+     */
+    Symbol name;
+
+    /**
+     * @brief The bound value.
+     */
+    T value;
+  };
+
+  /**
+   * @brief Bindings of all open scopes, innermost last.
+   */
+  std::vector<Binding> bindings;
+
+  /**
+   * @brief Indices of the first binding of each open scope except the
+   * outermost one.
+   */
+  std::vector<std::size_t> scope_begins;
+
+  /**
+   * @brief Get the index of the first binding of the innermost scope.
+   * @return The index in ``bindings``.
+   */
+  std::size_t current_scope_begin() const {
+    return scope_begins.empty() ? 0 : scope_begins.back();
+  }
+
+public:
+  /**
+   * @brief Open a scope nested in the current one.
+   */
+  void push_scope() { scope_begins.push_back(bindings.size()); }
+
+  /**
+   * @brief Close the innermost scope, dropping its bindings.
+   * @throw std::logic_error If only the outermost scope is open.
+   */
+  void pop_scope() {
+    if (scope_begins.empty())
+      throw std::logic_error("cannot pop the outermost scope");
+    bindings.resize(scope_begins.back());
+    scope_begins.pop_back();
+  }
+
+  /**
+   * @brief Drop all bindings and scopes, leaving only an empty outermost
+   * scope. The memory is kept for reuse.
+   */
+  void clear() {
+    bindings.clear();
+    scope_begins.clear();
+  }
+
+  /**
+   * @brief Bind a symbol in the innermost scope.
+   * @param name The symbol to bind.
+   * @param value The value to bind.
+   * @return Whether the symbol was bound, which is ``false`` if it is bound in
+   * the innermost scope already.
+   */
+  bool define(Symbol name, T value) {
+    for (auto i = current_scope_begin(); i < bindings.size(); i++)
+      if (bindings[i].name == name)
+        return false;
+    bindings.push_back({name, std::move(value)});
+    return true;
+  }
+
+  /**
+   * @brief Look up the innermost binding of a symbol.
+   * @param name The symbol to look up.
+   * @return Pointer to the bound value, or ``nullptr`` if the symbol is not
+   * bound. The pointer is invalidated by the next change of the stack.
+   */
+  const T *lookup(Symbol name) const {
+    for (auto it = bindings.rbegin(); it != bindings.rend(); it++)
+      if (it->name == name)
+        return &it->value;
+    return nullptr;
+  }
+
+  /**
+   * @brief Look up the innermost binding of a symbol.
+   * @param name The symbol to look up.
+   * @return Pointer to the bound value, or ``nullptr`` if the symbol is not
+   * bound. The pointer is invalidated by the next change of the stack.
+   */
+  T *lookup(Symbol name) {
+    return const_cast<T *>(std::as_const(*this).lookup(name));
+  }
+
+  /**
+   * @brief Get the number of bindings in all open scopes.
+   * @return The number of bindings.
+   */
+  std::size_t size() const { return bindings.size(); }
+
+  /**
+   * @brief Get a bound value by position. Stacks built by the same sequence
+   * of scopes and definitions have their bindings at the same positions.
+   * @param index The position of the binding, outermost first.
+   * @return The bound value.
+   */
+  T &operator[](std::size_t index) { return bindings[index].value; }
+
+  /**
+   * @brief Get a bound value by position.
+   * @param index The position of the binding, outermost first.
+   * @return The bound value.
+   */
+  const T &operator[](std::size_t index) const {
+    return bindings[index].value;
+  }
+
+  /**
+   * @brief Get the number of open scopes.
+   * @return The number of open scopes, including the outermost one.
+   */
+  std::size_t depth() const { return scope_begins.size() + 1; }
+};
+} // namespace stapl::util
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace stapl::util {
+/**
+ * @brief An interned name, such as a variable or function name.
+ *
+ * Symbols are dense 32-bit ids handed out by the global ``Interner``. Two
+ * symbols are equal if and only if their names are equal, so comparing and
+ * hashing symbols never touches the characters of the name.
+ */
+class Symbol {
+private:
+  /**
+   * @brief Id of the symbol in the global ``Interner``.
+   */
+  std::uint32_t symbol_id;
+
+public:
+  /**
+   * @brief Symbol of the empty name.
+   */
+  Symbol();
+
+  /**
+   * @brief Intern a name and instantiate the symbol of it.
+   * @param name The name to intern.
+   */
+  Symbol(std::string_view name);
+
+  /**
+   * @brief Intern a name and instantiate the symbol of it.
+   * @param name The name to intern.
+   */
+  Symbol(const char *name);
+
+  /**
+   * @brief Intern a name and instantiate the symbol of it.
+   * @param name The name to intern.
+   */
+  Symbol(const std::string &name);
+
+  /**
+   * @brief Instantiate from an id handed out by the global ``Interner``.
+   * @param symbol_id The id of the symbol.
+   * @return The symbol with id ``symbol_id``.
+   */
+  static Symbol from_id(std::uint32_t symbol_id);
+
+  /**
+   * @brief Get the id of the symbol.
+   * @return The dense id of the symbol.
+   */
+  std::uint32_t id() const;
+
+  /**
+   * @brief Get the name of the symbol.
+   * @return The interned name, which lives as long as the program.
+   */
+  std::string_view str() const;
+
+  /**
+   * @brief Comparision operator overload.
+   * @param rhs ``Symbol`` on the RHS.
+   * @return Whether ``this`` and ``rhs`` are the same name.
+   */
+  bool operator==(const Symbol &rhs) const = default;
+};
+
+/**
+ * @brief Interner handing out ``Symbol`` ids for names.
+ *
+ * The interner is shared by all compiler phases and is safe to use from
+ * multiple threads.
+ */
+class Interner {
+private:
+  /**
+   * @brief Interned names, indexed by symbol id.
+   */
+  std::deque<std::string> names;
+
+  /**
+   * @brief Mapping from interned names to symbol ids.
+   */
+  std::unordered_map<std::string_view, std::uint32_t> ids;
+
+  /**
+   * @brief Lock protecting ``names`` and ``ids``.
+   */
+  mutable std::shared_mutex lock;
+
+public:
+  /**
+   * @brief Default constructor. The empty name gets id 0.
+   */
+  Interner();
+
+  /**
+   * @brief Get the interner used by ``Symbol``.
+   * @return The global interner.
+   */
+  static Interner &global();
+
+  /**
+   * @brief Intern a name.
+   * @param name The name to intern.
+   * @return The id of ``name``, which is the same for every equal name.
+   */
+  std::uint32_t intern(std::string_view name);
+
+  /**
+   * @brief Get the name of an id.
+   * @param symbol_id The id to look up.
+   * @return The interned name of ``symbol_id``.
+   */
+  std::string_view name(std::uint32_t symbol_id) const;
+
+  /**
+   * @brief Get the number of interned names.
+   * @return The number of interned names, which is one more than the largest
+   * id.
+   */
+  std::size_t size() const;
+};
+} // namespace stapl::util
+
+/**
+ * @brief Hash of ``Symbol``, which is its id.
+ */
+template <> struct std::hash<stapl::util::Symbol> {
+  /**
+   * @brief Hash a symbol.
+   * @param symbol The symbol to hash.
+   * @return The id of ``symbol``.
+   */
+  std::size_t operator()(stapl::util::Symbol symbol) const noexcept {
+    return symbol.id();
+  }
+};
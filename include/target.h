@@ -0,0 +1,96 @@
+#pragma once
+
+#include "optimizer.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include <llvm/IR/Module.h>
+#include <llvm/Support/CodeGen.h>
+#include <llvm/Target/TargetMachine.h>
+
+/**
+ * @brief Generation of native code for a target machine.
+ */
+namespace stapl::target {
+/**
+ * @brief Kinds of files emitted by a target machine.
+ */
+enum class FileKind : std::uint8_t {
+  /**
+   * @brief Relocatable object file, such as ``.o``.
+   */
+  Object,
+
+  /**
+   * @brief Assembly in the syntax of the target, such as ``.s``.
+   */
+  Assembly
+};
+
+/**
+ * @brief Options selecting a target machine.
+ */
+struct TargetOptions {
+  /**
+   * @brief Target triple, such as ``x86_64-unknown-linux-gnu``. The host
+   * triple is used if empty.
+   */
+  std::string triple;
+
+  /**
+   * @brief CPU to tune and select instructions for. ``native`` is the CPU of
+   * the host, and the generic CPU of the target is used if empty.
+   */
+  std::string cpu;
+
+  /**
+   * @brief Optimization level of instruction selection and code generation.
+   */
+  opt::OptLevel opt_level = opt::OptLevel::O0;
+};
+
+/**
+ * @brief Get the code generation level matching an optimization level.
+ * @param level The optimization level of the IR pipeline.
+ * @return The level of instruction selection and code generation.
+ */
+llvm::CodeGenOpt::Level codegen_opt_level(opt::OptLevel level);
+
+/**
+ * @brief Create a target machine.
+ *
+ * Position independent code is generated, so that objects can be linked into
+ * executables and shared libraries alike.
+ * @param options The options selecting the machine.
+ * @return The target machine.
+ * @throw std::logic_error If the triple is not supported by this build of
+ * LLVM.
+ */
+std::unique_ptr<llvm::TargetMachine>
+create_target_machine(const TargetOptions &options);
+
+/**
+ * @brief Set the triple and data layout of a module to the ones of a target
+ * machine.
+ *
+ * This should be done before optimization, so that passes see the sizes and
+ * alignments of the target.
+ * @param module The module.
+ * @param machine The target machine.
+ */
+void set_target(llvm::Module &module, const llvm::TargetMachine &machine);
+
+/**
+ * @brief Generate native code for a module and write it to a file.
+ * @param module The module, whose target is already set to ``machine``.
+ * @param machine The target machine.
+ * @param path Path of the file to write.
+ * @param kind Kind of the file to write.
+ * @throw std::logic_error If the file cannot be opened, or the target cannot
+ * emit files of ``kind``.
+ */
+void emit_file(llvm::Module &module, llvm::TargetMachine &machine,
+               const std::string &path, FileKind kind);
+} // namespace stapl::target
@@ -0,0 +1,136 @@
+#pragma once
+
+#include "lexer.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace stapl::parsing {
+/**
+ * @brief Tokens of a whole code, stored as a struct of arrays.
+ *
+ * Each token is a kind, an offset and a length into the code, and an index
+ * into the payloads of number literals. The arrays are contiguous, so walking
+ * and indexing the tokens is cheap, and the buffer can be kept around for
+ * later phases. The code must outlive the buffer.
+ */
+class TokenBuffer {
+private:
+  /**
+   * @brief Code the tokens view into.
+   */
+  std::string_view code;
+
+  /**
+   * @brief Kinds of the tokens.
+   */
+  std::vector<TokenKind> kinds;
+
+  /**
+   * @brief Offsets of the tokens in ``code``.
+   */
+  std::vector<std::uint32_t> offsets;
+
+  /**
+   * @brief Lengths of the tokens.
+   */
+  std::vector<std::uint32_t> lengths;
+
+  /**
+   * @brief Indices of the token values in ``payloads``, or ``no_payload`` for
+   * tokens without a value.
+   */
+  std::vector<std::uint32_t> payload_indices;
+
+  /**
+   * @brief Values of number literals and of operators.
+   */
+  std::vector<TokenValue> payloads;
+
+  /**
+   * @brief Payload index of tokens without a value.
+   */
+  static constexpr std::uint32_t no_payload = UINT32_MAX;
+
+public:
+  /**
+   * @brief Instantiate an empty buffer.
+   */
+  TokenBuffer() = default;
+
+  /**
+   * @brief Lex the whole code into a buffer.
+   * @param code Code to be lexed. It must outlive the buffer.
+   * @throw std::logic_error If the code is 4 GiB or larger, or if a number
+   * literal is malformed or out of range.
+   */
+  TokenBuffer(std::string_view code);
+
+  /**
+   * @brief Store tokens lexed in advance into a buffer.
+   * @param code Code the tokens view into. It must outlive the buffer.
+   * @param tokens Tokens of ``code``, such as those returned by
+   * ``tokenize_parallel``.
+   * @throw std::logic_error If the code is 4 GiB or larger, or if a token does
+   * not view into the code.
+   */
+  TokenBuffer(std::string_view code, const std::vector<Token> &tokens);
+
+  /**
+   * @brief Append a token.
+   * @param token Token viewing into the code of the buffer.
+   * @throw std::logic_error If the token does not view into the code.
+   */
+  void push_back(const Token &token);
+
+  /**
+   * @brief Get the number of tokens.
+   * @return The number of tokens in the buffer.
+   */
+  std::size_t size() const;
+
+  /**
+   * @brief Get the code the tokens view into.
+   * @return The code of the buffer.
+   */
+  std::string_view get_code() const;
+
+  /**
+   * @brief Get the kind of a token.
+   * @param index Index of the token.
+   * @return The kind of the token.
+   */
+  TokenKind kind(std::size_t index) const;
+
+  /**
+   * @brief Get the offset of a token in the code.
+   * @param index Index of the token.
+   * @return The offset of the token.
+   */
+  std::size_t offset(std::size_t index) const;
+
+  /**
+   * @brief Get the text of a token.
+   * @param index Index of the token.
+   * @return The text of the token, viewing into the code.
+   */
+  std::string_view text(std::size_t index) const;
+
+  /**
+   * @brief Get the value of a token.
+   * @param index Index of the token.
+   * @return The value of the token, which is empty unless it is a number
+   * literal or an operator.
+   */
+  TokenValue value(std::size_t index) const;
+
+  /**
+   * @brief Get a token.
+   * @param index Index of the token.
+   * @return The token at ``index``.
+   */
+  Token operator[](std::size_t index) const;
+};
+} // namespace stapl::parsing
@@ -1,49 +1,248 @@
 #pragma once
 
+#include "symbol.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <shared_mutex>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 
 namespace stapl::types {
 /**
- * @brief Type information of a function.
+ * @brief Kinds of types.
+ */
+enum class TypeKind : std::uint8_t {
+  /**
+   * @brief Not a type, which is the kind of the empty type name.
+   */
+  None,
+
+  /**
+   * @brief The ``void`` type.
+   */
+  Void,
+
+  /**
+   * @brief The ``int`` type.
+   */
+  Int,
+
+  /**
+   * @brief The ``float`` type.
+   */
+  Float,
+
+  /**
+   * @brief The ``bool`` type.
+   */
+  Bool,
+
+  /**
+   * @brief A type known only by its name, which is not a builtin type.
+   */
+  Named
+};
+
+/**
+ * @brief An interned type.
+ *
+ * Types are dense 32-bit ids handed out by the global ``TypeTable``, so two
+ * types are equal if and only if their ids are equal. Builtin types have fixed
+ * ids, which can be used in constant expressions.
+ */
+class TypeId {
+private:
+  /**
+   * @brief Id of the type in the global ``TypeTable``.
+   */
+  std::uint32_t type_id = 0;
+
+public:
+  /**
+   * @brief Type of the empty type name, which is not a type.
+   */
+  constexpr TypeId() = default;
+
+  /**
+   * @brief Intern a type name and instantiate the type of it.
+   * @param name The type name to intern.
+   */
+  TypeId(std::string_view name);
+
+  /**
+   * @brief Intern a type name and instantiate the type of it.
+   * @param name The type name to intern.
+   */
+  TypeId(const char *name);
+
+  /**
+   * @brief Intern a type name and instantiate the type of it.
+   * @param name The type name to intern.
+   */
+  TypeId(const std::string &name);
+
+  /**
+   * @brief Instantiate from an id handed out by the global ``TypeTable``.
+   * @param type_id The id of the type.
+   * @return The type with id ``type_id``.
+   */
+  static constexpr TypeId from_id(std::uint32_t type_id) {
+    TypeId type;
+    type.type_id = type_id;
+    return type;
+  }
+
+  /**
+   * @brief Get the id of the type.
+   * @return The dense id of the type.
+   */
+  constexpr std::uint32_t id() const { return type_id; }
+
+  /**
+   * @brief Get the name of the type.
+   * @return The type name, which lives as long as the program.
+   */
+  std::string_view str() const;
+
+  /**
+   * @brief Get the kind of the type.
+   * @return The kind of the type.
+   */
+  TypeKind kind() const;
+
+  /**
+   * @brief Comparision operator overload.
+   * @param rhs ``TypeId`` on the RHS.
+   * @return Whether ``this`` and ``rhs`` are the same type.
+   */
+  constexpr bool operator==(const TypeId &rhs) const = default;
+};
+
+/**
+ * @brief The ``void`` type.
+ */
+constexpr TypeId void_type = TypeId::from_id(1);
+
+/**
+ * @brief The ``int`` type.
  */
-struct FuncTypeInfo {
+constexpr TypeId int_type = TypeId::from_id(2);
+
+/**
+ * @brief The ``float`` type.
+ */
+constexpr TypeId float_type = TypeId::from_id(3);
+
+/**
+ * @brief The ``bool`` type.
+ */
+constexpr TypeId bool_type = TypeId::from_id(4);
+
+/**
+ * @brief Table handing out ``TypeId`` ids for types.
+ *
+ * The table is shared by all compiler phases and is safe to use from multiple
+ * threads. The builtin types are interned first, so that their ids match the
+ * constants above.
+ */
+class TypeTable {
+private:
+  /**
+   * @brief Information of an interned type.
+   */
+  struct TypeInfo {
+    /**
+     * @brief Name of the type.
+     */
+    util::Symbol name;
+
+    /**
+     * @brief Kind of the type.
+     */
+    TypeKind kind;
+  };
+
   /**
-   * @brief The type names of arguments.
+   * @brief Interned types, indexed by type id.
    */
-  std::vector<std::string> arg_types;
+  std::vector<TypeInfo> types;
 
   /**
-   * @brief The type name of returned value.
+   * @brief Mapping from type names to type ids.
    */
-  std::string return_type;
+  std::unordered_map<util::Symbol, std::uint32_t> ids;
 
   /**
-   * @brief Default constructor.
+   * @brief Lock protecting ``types`` and ``ids``.
    */
-  FuncTypeInfo() = default;
+  mutable std::shared_mutex lock;
 
   /**
-   * @brief Copy constructor.
+   * @brief Intern a type of a given kind.
+   * @param name The name of the type.
+   * @param kind The kind of the type, used if the type is new.
+   * @return The id of the type.
    */
-  FuncTypeInfo(const FuncTypeInfo &) = default;
+  std::uint32_t intern(util::Symbol name, TypeKind kind);
 
+public:
   /**
-   * @brief Move constructor.
+   * @brief Default constructor. Interns the empty type name and the builtin
+   * types.
    */
-  FuncTypeInfo(FuncTypeInfo &&) = default;
+  TypeTable();
 
   /**
-   * @brief Instantiate from argument types and return type.
-   * @param arg_types The types of arguments.
-   * @param return_type The return type.
+   * @brief Get the table used by ``TypeId``.
+   * @return The global type table.
    */
-  FuncTypeInfo(const std::vector<std::string> &arg_types,
-               const std::string &return_type);
+  static TypeTable &global();
 
   /**
-   * @brief Copy assignment operator.
+   * @brief Intern a type name. Names of builtin types map to the builtin
+   * types, and other names to ``TypeKind::Named`` types.
+   * @param name The type name to intern.
+   * @return The id of ``name``, which is the same for every equal name.
    */
-  FuncTypeInfo &operator=(const FuncTypeInfo &) = default;
+  std::uint32_t intern(std::string_view name);
+
+  /**
+   * @brief Get the name of a type.
+   * @param type_id The id to look up.
+   * @return The name of the type ``type_id``.
+   */
+  std::string_view name(std::uint32_t type_id) const;
+
+  /**
+   * @brief Get the kind of a type.
+   * @param type_id The id to look up.
+   * @return The kind of the type ``type_id``.
+   */
+  TypeKind kind(std::uint32_t type_id) const;
+
+  /**
+   * @brief Get the number of interned types.
+   * @return The number of interned types, which is one more than the largest
+   * id.
+   */
+  std::size_t size() const;
 };
 } // namespace stapl::types
+
+/**
+ * @brief Hash of ``TypeId``, which is its id.
+ */
+template <> struct std::hash<stapl::types::TypeId> {
+  /**
+   * @brief Hash a type.
+   * @param type The type to hash.
+   * @return The id of ``type``.
+   */
+  std::size_t operator()(stapl::types::TypeId type) const noexcept {
+    return type.id();
+  }
+};
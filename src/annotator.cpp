@@ -1,128 +1,155 @@
 #include "annotator.h"
 #include "ast.h"
+#include "flat_ast.h"
+#include "ops.h"
+#include "overload.h"
+#include "symbol.h"
+#include "types.h"
 
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <future>
 #include <iterator>
 #include <memory>
+#include <mutex>
+#include <span>
 #include <stdexcept>
-#include <string>
 #include <variant>
 #include <vector>
 
 #include <fmt/core.h>
 
 namespace stapl::types {
-TypeAnnotator::TypeAnnotator() {
-  func_types["+"] = func_types["-"] = {{{"int", "int"}, "int"},
-                                       {{"float", "float"}, "float"},
-                                       {{"int"}, "int"},
-                                       {{"float"}, "float"}};
-  func_types["*"] = func_types["/"] = {{{"int", "int"}, "int"},
-                                       {{"float", "float"}, "float"}};
-  func_types["%"] = {{{"int", "int"}, "int"}};
-  func_types["!"] = {{{"bool"}, "bool"}};
-  func_types["=="] = func_types["!="] = func_types["<"] = func_types[">"] =
-      func_types["<="] = func_types[">="] = {{{"int", "int"}, "bool"},
-                                             {{"float", "float"}, "bool"},
-                                             {{"bool", "bool"}, "bool"}};
+TypeAnnotator::TypeAnnotator() = default;
+
+TypeAnnotator::TypeAnnotator(const OverloadTable &signatures)
+    : shared_signatures(&signatures) {}
+
+const OverloadTable &TypeAnnotator::signatures() const {
+  return shared_signatures != nullptr ? *shared_signatures : overloads;
 }
 
-std::string TypeAnnotator::operator()(ast::LiteralExprNode<int> &node) {
-  node.expr_type = "int";
-  return "int";
+TypeId TypeAnnotator::op_return_type(ast::Op op, std::size_t arity,
+                                     const std::array<TypeId, 2> &arg_types) {
+  auto return_type = ast::op_return_type(op, arity, arg_types);
+  if (!return_type)
+    throw std::logic_error(
+        fmt::format("no matching signature of {}", ast::op_text(op)));
+  return *return_type;
 }
 
-std::string TypeAnnotator::operator()(ast::LiteralExprNode<double> &node) {
-  node.expr_type = "float";
-  return "float";
+TypeId TypeAnnotator::operator()(ast::LiteralExprNode<int> &node) {
+  node.expr_type = int_type;
+  return int_type;
 }
 
-std::string TypeAnnotator::operator()(ast::LiteralExprNode<bool> &node) {
-  node.expr_type = "bool";
-  return "bool";
+TypeId TypeAnnotator::operator()(ast::LiteralExprNode<double> &node) {
+  node.expr_type = float_type;
+  return float_type;
 }
 
-std::string TypeAnnotator::operator()(ast::VariableExprNode &node) {
-  node.expr_type = variable_type_names.at(node.name);
+TypeId TypeAnnotator::operator()(ast::LiteralExprNode<bool> &node) {
+  node.expr_type = bool_type;
+  return bool_type;
+}
+
+TypeId TypeAnnotator::operator()(ast::VariableExprNode &node) {
+  node.expr_type = variable_type(node.name);
   return node.expr_type.value();
 }
 
-std::string
-TypeAnnotator::operator()(std::unique_ptr<ast::UnaryExprNode> &node) {
+TypeId TypeAnnotator::operator()(std::unique_ptr<ast::UnaryExprNode> &node) {
   if (node->expr_type.has_value())
     return node->expr_type.value();
-  for (const auto &func_type : func_types.at(node->op)) {
-    if (func_type.arg_types !=
-        std::vector<std::string>{std::visit(*this, node->rhs)})
-      continue;
-    node->expr_type = func_type.return_type;
-  }
+  node->expr_type =
+      op_return_type(node->op, 1, {std::visit(*this, node->rhs)});
   return node->expr_type.value();
 }
 
-std::string
-TypeAnnotator::operator()(std::unique_ptr<ast::BinaryExprNode> &node) {
+TypeId TypeAnnotator::operator()(std::unique_ptr<ast::BinaryExprNode> &node) {
   if (node->expr_type.has_value())
     return node->expr_type.value();
 
-  std::string lhs_type = std::visit(*this, node->lhs),
-              rhs_type = std::visit(*this, node->rhs);
-  for (const auto &func_type : func_types.at(node->op)) {
-    if (func_type.arg_types != std::vector<std::string>{lhs_type, rhs_type})
-      continue;
-    node->expr_type = func_type.return_type;
-  }
+  TypeId lhs_type = std::visit(*this, node->lhs),
+         rhs_type = std::visit(*this, node->rhs);
+  node->expr_type = op_return_type(node->op, 2, {lhs_type, rhs_type});
   return node->expr_type.value();
 }
 
-std::string
-TypeAnnotator::operator()(std::unique_ptr<ast::CallExprNode> &node) {
+TypeId TypeAnnotator::operator()(std::unique_ptr<ast::CallExprNode> &node) {
   if (node->expr_type.has_value())
     return node->expr_type.value();
 
-  std::vector<std::string> arg_types;
-  for (auto &arg : node->args)
-    arg_types.push_back(std::visit(*this, arg));
-  for (const auto &func_type : func_types.at(node->callee)) {
-    if (func_type.arg_types != arg_types)
-      continue;
-    node->expr_type = func_type.return_type;
+  auto args_begin = arg_type_stack.size();
+  for (auto &arg : node->args) {
+    auto arg_type = std::visit(*this, arg);
+    arg_type_stack.push_back(arg_type);
   }
+  node->expr_type = resolve_call(node->callee, args_begin);
   return node->expr_type.value();
 }
 
+TypeId TypeAnnotator::resolve_call(util::Symbol callee,
+                                   std::size_t args_begin) {
+  auto return_type =
+      signatures().find(callee, std::span(arg_type_stack).subspan(args_begin));
+  arg_type_stack.resize(args_begin);
+  if (!return_type)
+    throw std::logic_error(
+        fmt::format("no matching signature of {}", callee.str()));
+  return *return_type;
+}
+
 void TypeAnnotator::operator()(ast::LetStmtNode &node) {
-  variable_type_names[node.var_name] = node.var_type;
+  define_variable(node.var_name, node.var_type);
 }
 
-void TypeAnnotator::operator()(ast::AssignmentStmtNode &node) {
-  std::string rhs_type = std::visit(*this, node.assign_expr),
-              var_type = variable_type_names.at(node.var_name);
+TypeId TypeAnnotator::variable_type(util::Symbol name) const {
+  const TypeId *type = variable_types.lookup(name);
+  if (type == nullptr)
+    throw std::logic_error(fmt::format("unknown variable: {}", name.str()));
+  return *type;
+}
+
+void TypeAnnotator::define_variable(util::Symbol name, TypeId type) {
+  if (!variable_types.define(name, type))
+    throw std::logic_error(
+        fmt::format("redefinition of variable {}", name.str()));
+}
+
+void TypeAnnotator::check_assignment(util::Symbol var_name, TypeId rhs_type) {
+  TypeId var_type = variable_type(var_name);
 
   // TODO: add dedicated exception for type error
   if (rhs_type != var_type)
-    throw std::logic_error(fmt::format(
-        "type mismatch: variable is {} but rhs is {}", var_type, rhs_type));
+    throw std::logic_error(
+        fmt::format("type mismatch: variable is {} but rhs is {}",
+                    var_type.str(), rhs_type.str()));
 }
 
-void TypeAnnotator::operator()(std::unique_ptr<ast::IfStmtNode> &node) {
-  std::string condition_type = std::visit(*this, node->condition);
-
+void TypeAnnotator::check_condition(TypeId condition_type) {
   // TODO: add dedicated exception for type error
-  if (condition_type != "bool")
-    throw std::logic_error(fmt::format(
-        "type mismatch: condition must be bool but {}", condition_type));
+  if (condition_type != bool_type)
+    throw std::logic_error(
+        fmt::format("type mismatch: condition must be bool but {}",
+                    condition_type.str()));
+}
+
+void TypeAnnotator::operator()(ast::AssignmentStmtNode &node) {
+  check_assignment(node.var_name, std::visit(*this, node.assign_expr));
+}
+
+void TypeAnnotator::operator()(std::unique_ptr<ast::IfStmtNode> &node) {
+  check_condition(std::visit(*this, node->condition));
   std::visit(*this, node->then_stmt);
   std::visit(*this, node->else_stmt);
 }
 
 void TypeAnnotator::operator()(std::unique_ptr<ast::WhileStmtNode> &node) {
-  std::string condition_type = std::visit(*this, node->condition);
-
-  // TODO: add dedicated exception for type error
-  if (condition_type != "bool")
-    throw std::logic_error(fmt::format(
-        "type mismatch: condition must be bool but {}", condition_type));
+  check_condition(std::visit(*this, node->condition));
   std::visit(*this, node->body);
 }
 
@@ -135,25 +162,231 @@ void TypeAnnotator::operator()(ast::ReturnStmtNode &node) {
 }
 
 void TypeAnnotator::operator()(std::unique_ptr<ast::CompoundStmtNode> &node) {
+  variable_types.push_scope();
   for (auto &stmt : node->stmts)
     std::visit(*this, stmt);
+  variable_types.pop_scope();
 }
 
-void TypeAnnotator::operator()(ast::FunctionDeclNode &node) {
-  std::string return_type = node.proto.return_type;
-  std::vector<std::string> arg_types;
-  variable_type_names.clear();
-  for (const auto &[arg_name, arg_type] : node.proto.args) {
-    arg_types.push_back(arg_type);
-    if (variable_type_names.count(arg_name))
+void TypeAnnotator::declare_function(const ast::PrototypeNode &proto) {
+  if (shared_signatures != nullptr)
+    return;
+  auto args_begin = arg_type_stack.size();
+  for (const auto &arg : proto.args)
+    arg_type_stack.push_back(arg.second);
+  overloads.add(proto.name, std::span(arg_type_stack).subspan(args_begin),
+                proto.return_type);
+  arg_type_stack.resize(args_begin);
+}
+
+void TypeAnnotator::enter_function(const ast::PrototypeNode &proto) {
+  variable_types.clear();
+  for (const auto &[arg_name, arg_type] : proto.args)
+    if (!variable_types.define(arg_name, arg_type))
       throw std::logic_error(
-          fmt::format("redefinition of argument {}", arg_name));
-    variable_type_names[arg_name] = arg_type;
-  }
-  if (!func_types.count(node.proto.name))
-    func_types[node.proto.name] = {};
-  func_types[node.proto.name].push_back({arg_types, return_type});
+          fmt::format("redefinition of argument {}", arg_name.str()));
+}
+
+void TypeAnnotator::operator()(ast::FunctionDeclNode &node) {
+  declare_function(node.proto);
+  enter_function(node.proto);
   if (node.func_body.has_value())
     std::visit(*this, node.func_body.value());
 }
+
+TypeId TypeAnnotator::annotate_flat_expr(ast::FlatExprPool &exprs,
+                                         ast::IndexRange range) {
+  // Children come before their parent, so a single forward pass sees the types
+  // of the operands of every node.
+  for (auto i = range.begin; i < range.end; i++) {
+    auto name = util::Symbol::from_id(exprs.payloads[i]);
+    switch (exprs.kinds[i]) {
+    case ast::FlatExprKind::Int:
+      exprs.types[i] = int_type;
+      continue;
+    case ast::FlatExprKind::Float:
+      exprs.types[i] = float_type;
+      continue;
+    case ast::FlatExprKind::Bool:
+      exprs.types[i] = bool_type;
+      continue;
+    case ast::FlatExprKind::Variable:
+      exprs.types[i] = variable_type(name);
+      continue;
+    default:
+      break;
+    }
+
+    if (exprs.kinds[i] == ast::FlatExprKind::Unary) {
+      auto op = static_cast<ast::Op>(exprs.payloads[i]);
+      exprs.types[i] = op_return_type(op, 1, {exprs.types[i - 1]});
+      continue;
+    }
+    if (exprs.kinds[i] == ast::FlatExprKind::Binary) {
+      auto op = static_cast<ast::Op>(exprs.payloads[i]);
+      auto lhs = exprs.subtree_begins[i - 1] - 1;
+      exprs.types[i] =
+          op_return_type(op, 2, {exprs.types[lhs], exprs.types[i - 1]});
+      continue;
+    }
+
+    auto args_begin = arg_type_stack.size();
+    arg_type_stack.resize(args_begin + exprs.arities[i]);
+    ast::NodeIndex child = i;
+    for (auto it = arg_type_stack.rbegin();
+         it != arg_type_stack.rend() - args_begin; it++) {
+      child--;
+      *it = exprs.types[child];
+      child = exprs.subtree_begins[child];
+    }
+    exprs.types[i] = resolve_call(name, args_begin);
+  }
+  return exprs.types[range.end - 1];
+}
+
+void TypeAnnotator::annotate_flat_stmt(ast::FlatModule &module,
+                                       ast::FlatStmtRef stmt) {
+  auto &exprs = module.exprs;
+  switch (stmt.kind) {
+  case ast::FlatStmtKind::Let: {
+    const auto &let = module.lets[stmt.index];
+    define_variable(let.var_name, let.var_type);
+    break;
+  }
+  case ast::FlatStmtKind::Assignment: {
+    const auto &assignment = module.assignments[stmt.index];
+    check_assignment(assignment.var_name,
+                     annotate_flat_expr(exprs, assignment.assign_expr));
+    break;
+  }
+  case ast::FlatStmtKind::If: {
+    const auto &if_stmt = module.ifs[stmt.index];
+    check_condition(annotate_flat_expr(exprs, if_stmt.condition));
+    annotate_flat_stmt(module, if_stmt.then_stmt);
+    annotate_flat_stmt(module, if_stmt.else_stmt);
+    break;
+  }
+  case ast::FlatStmtKind::While: {
+    const auto &while_stmt = module.whiles[stmt.index];
+    check_condition(annotate_flat_expr(exprs, while_stmt.condition));
+    annotate_flat_stmt(module, while_stmt.body);
+    break;
+  }
+  case ast::FlatStmtKind::Break:
+  case ast::FlatStmtKind::Continue:
+    break;
+  case ast::FlatStmtKind::Return:
+    annotate_flat_expr(exprs, module.returns[stmt.index].return_expr);
+    break;
+  case ast::FlatStmtKind::Compound: {
+    auto range = module.compounds[stmt.index].stmts;
+    variable_types.push_scope();
+    for (auto i = range.begin; i < range.end; i++)
+      annotate_flat_stmt(module, module.stmt_lists[i]);
+    variable_types.pop_scope();
+    break;
+  }
+  }
+}
+
+void TypeAnnotator::operator()(ast::FlatModule &module) {
+  for (const auto &func : module.functions)
+    declare_function(func.proto);
+  for (std::size_t i = 0; i < module.functions.size(); i++)
+    annotate_function(module, i);
+}
+
+void TypeAnnotator::annotate_function(ast::FlatModule &module,
+                                      std::size_t index) {
+  const auto &func = module.functions[index];
+  enter_function(func.proto);
+  if (func.func_body.has_value())
+    annotate_flat_stmt(module, func.func_body.value());
+}
+
+namespace {
+template <typename F>
+void annotate_parallel(const OverloadTable &signatures, std::size_t count,
+                       unsigned jobs, F annotate_one) {
+  // Functions are handed out in order, and a worker stops taking functions
+  // past the first failed one. Every function before the first failure is
+  // annotated, so the reported error does not depend on scheduling.
+  std::atomic<std::size_t> next_index = 0;
+  std::mutex error_lock;
+  std::size_t error_index = count;
+  std::exception_ptr error;
+  auto work = [&] {
+    TypeAnnotator annotator(signatures);
+    while (true) {
+      auto index = next_index.fetch_add(1);
+      {
+        std::lock_guard guard(error_lock);
+        if (index >= error_index)
+          return;
+      }
+      try {
+        annotate_one(annotator, index);
+      } catch (...) {
+        std::lock_guard guard(error_lock);
+        if (index < error_index) {
+          error_index = index;
+          error = std::current_exception();
+        }
+        return;
+      }
+    }
+  };
+
+  std::size_t worker_count = std::min<std::size_t>(jobs, count);
+  std::vector<std::future<void>> futures;
+  for (std::size_t i = 1; i < worker_count; i++)
+    futures.push_back(std::async(std::launch::async, work));
+  work();
+  for (auto &future : futures)
+    future.get();
+  if (error)
+    std::rethrow_exception(error);
+}
+} // namespace
+
+OverloadTable collect_signatures(const ast::Module &module) {
+  OverloadTable signatures;
+  std::vector<TypeId> arg_types;
+  for (const auto &decl : module.decls) {
+    const auto &proto = std::get<ast::FunctionDeclNode>(decl).proto;
+    arg_types.clear();
+    for (const auto &arg : proto.args)
+      arg_types.push_back(arg.second);
+    signatures.add(proto.name, arg_types, proto.return_type);
+  }
+  return signatures;
+}
+
+OverloadTable collect_signatures(const ast::FlatModule &module) {
+  OverloadTable signatures;
+  std::vector<TypeId> arg_types;
+  for (const auto &func : module.functions) {
+    arg_types.clear();
+    for (const auto &arg : func.proto.args)
+      arg_types.push_back(arg.second);
+    signatures.add(func.proto.name, arg_types, func.proto.return_type);
+  }
+  return signatures;
+}
+
+void annotate_module(ast::Module &module, unsigned jobs) {
+  auto signatures = collect_signatures(module);
+  annotate_parallel(signatures, module.decls.size(), jobs,
+                    [&](TypeAnnotator &annotator, std::size_t index) {
+                      std::visit(annotator, module.decls[index]);
+                    });
+}
+
+void annotate_module(ast::FlatModule &module, unsigned jobs) {
+  auto signatures = collect_signatures(module);
+  annotate_parallel(signatures, module.functions.size(), jobs,
+                    [&](TypeAnnotator &annotator, std::size_t index) {
+                      annotator.annotate_function(module, index);
+                    });
+}
 } // namespace stapl::types
@@ -0,0 +1,45 @@
+#include "arena.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace stapl::util {
+thread_local Arena *Arena::current_arena = nullptr;
+
+Arena::Scope::Scope(Arena *arena) : previous(current_arena) {
+  current_arena = arena;
+}
+
+Arena::Scope::~Scope() { current_arena = previous; }
+
+Arena::Arena(std::size_t block_size) : block_size(block_size) {}
+
+void *Arena::allocate(std::size_t size, std::size_t alignment) {
+  auto address = reinterpret_cast<std::uintptr_t>(cursor);
+  std::size_t padding = -address & (alignment - 1);
+  if (cursor == nullptr || size + padding > std::size_t(limit - cursor)) {
+    // Oversized allocations get a block of their own, so that the rest of the
+    // current block is not wasted.
+    std::size_t new_block_size = size > block_size / 4 ? size : block_size;
+    auto &block = blocks.emplace_back(new std::byte[new_block_size]);
+    reserved += new_block_size;
+    used += size;
+    if (new_block_size != block_size)
+      return block.get();
+    cursor = block.get();
+    limit = cursor + new_block_size;
+    padding = 0;
+  } else
+    used += size + padding;
+  void *result = cursor + padding;
+  cursor += padding + size;
+  return result;
+}
+
+std::size_t Arena::bytes_used() const { return used; }
+
+std::size_t Arena::bytes_reserved() const { return reserved; }
+
+Arena *Arena::current() { return current_arena; }
+} // namespace stapl::util
@@ -1,6 +1,10 @@
 #include "ast.h"
+#include "arena.h"
 
+#include <cstddef>
 #include <cstdint>
+#include <memory>
+#include <new>
 #include <stdexcept>
 #include <string>
 #include <utility>
@@ -9,33 +13,52 @@
 #include <fmt/core.h>
 
 namespace stapl::ast {
+namespace {
+// Header in front of each node, keeping the node aligned.
+struct alignas(std::max_align_t) NodeHeader {
+  util::Arena *arena;
+};
+} // namespace
+
+void *ArenaNode::operator new(std::size_t size) {
+  auto *arena = util::Arena::current();
+  void *memory =
+      arena == nullptr
+          ? ::operator new(sizeof(NodeHeader) + size)
+          : arena->allocate(sizeof(NodeHeader) + size, alignof(NodeHeader));
+  auto *header = new (memory) NodeHeader{arena};
+  return header + 1;
+}
+
+void ArenaNode::operator delete(void *ptr) {
+  auto *header = static_cast<NodeHeader *>(ptr) - 1;
+  if (header->arena == nullptr)
+    ::operator delete(header);
+}
+
 template <typename T>
 LiteralExprNode<T>::LiteralExprNode(T value) : value(value) {}
 
-VariableExprNode::VariableExprNode(const std::string &name) : name(name) {}
+VariableExprNode::VariableExprNode(util::Symbol name) : name(name) {}
 
-UnaryExprNode::UnaryExprNode(const std::string &op, ExprNode rhs)
+UnaryExprNode::UnaryExprNode(Op op, ExprNode rhs)
     : op(op), rhs(std::move(rhs)) {}
 
-BinaryExprNode::BinaryExprNode(const std::string &op, ExprNode lhs,
-                               ExprNode rhs)
+BinaryExprNode::BinaryExprNode(Op op, ExprNode lhs, ExprNode rhs)
     : op(op), lhs(std::move(lhs)), rhs(std::move(rhs)) {}
 
-CallExprNode::CallExprNode(const std::string &callee,
-                           std::vector<ExprNode> args)
+CallExprNode::CallExprNode(util::Symbol callee, std::vector<ExprNode> args)
     : callee(callee), args(std::move(args)) {}
 
 PrototypeNode::PrototypeNode(
-    const std::string &name,
-    std::vector<std::pair<std::string, std::string>> args,
-    const std::string &return_type)
-    : name(name), return_type(return_type), args(args) {}
+    util::Symbol name, std::vector<std::pair<util::Symbol, types::TypeId>> args,
+    types::TypeId return_type)
+    : name(name), return_type(return_type), args(std::move(args)) {}
 
-LetStmtNode::LetStmtNode(const std::string &var_name,
-                         const std::string &var_type)
+LetStmtNode::LetStmtNode(util::Symbol var_name, types::TypeId var_type)
     : var_name(var_name), var_type(var_type) {}
 
-AssignmentStmtNode::AssignmentStmtNode(const std::string &var_name,
+AssignmentStmtNode::AssignmentStmtNode(util::Symbol var_name,
                                        ExprNode assign_expr)
     : var_name(var_name), assign_expr(std::move(assign_expr)) {}
 
@@ -59,8 +82,16 @@ FunctionDeclNode::FunctionDeclNode(PrototypeNode proto, StmtNode func_body)
 FunctionDeclNode::FunctionDeclNode(PrototypeNode proto)
     : proto(std::move(proto)), func_body({}) {}
 
-Module::Module(const std::string &name, std::vector<DeclNode> decls)
-    : name(name), decls(std::move(decls)) {}
+Module::Module(const std::string &name, std::vector<DeclNode> decls,
+               std::unique_ptr<util::Arena> arena)
+    : name(name), arena(std::move(arena)), decls(std::move(decls)) {}
+
+Module &Module::operator=(Module &&rhs) {
+  name = std::move(rhs.name);
+  decls = std::move(rhs.decls);
+  arena = std::move(rhs.arena);
+  return *this;
+}
 
 template class LiteralExprNode<int>;
 template class LiteralExprNode<double>;
@@ -18,18 +18,18 @@ std::string ASTPrinter::operator()(const LiteralExprNode<bool> &node) const {
 }
 
 std::string ASTPrinter::operator()(const VariableExprNode &node) const {
-  return fmt::format("Variable({})", node.name);
+  return fmt::format("Variable({})", node.name.str());
 }
 
 std::string
 ASTPrinter::operator()(const std::unique_ptr<UnaryExprNode> &node) const {
-  return fmt::format("UnaryExpr({}, {})", node->op,
+  return fmt::format("UnaryExpr({}, {})", op_text(node->op),
                      std::visit(*this, node->rhs));
 }
 
 std::string
 ASTPrinter::operator()(const std::unique_ptr<BinaryExprNode> &node) const {
-  return fmt::format("BinaryExpr({}, {}, {})", node->op,
+  return fmt::format("BinaryExpr({}, {}, {})", op_text(node->op),
                      std::visit(*this, node->lhs),
                      std::visit(*this, node->rhs));
 }
@@ -42,7 +42,7 @@ ASTPrinter::operator()(const std::unique_ptr<CallExprNode> &node) const {
       arg_str.append(", ");
     arg_str.append(std::visit(*this, arg));
   }
-  return fmt::format("CallExpr({}, [{}])", node->callee, arg_str);
+  return fmt::format("CallExpr({}, [{}])", node->callee.str(), arg_str);
 }
 
 std::string ASTPrinter::operator()(const PrototypeNode &node) const {
@@ -50,18 +50,20 @@ std::string ASTPrinter::operator()(const PrototypeNode &node) const {
   for (auto &arg : node.args) {
     if (!arg_str.empty())
       arg_str.append(", ");
-    arg_str.append(fmt::format("Arg({}, {})", arg.first, arg.second));
+    arg_str.append(
+        fmt::format("Arg({}, {})", arg.first.str(), arg.second.str()));
   }
-  return fmt::format("Prototype({}, [{}], {})", node.name, arg_str,
-                     node.return_type);
+  return fmt::format("Prototype({}, [{}], {})", node.name.str(), arg_str,
+                     node.return_type.str());
 }
 
 std::string ASTPrinter::operator()(const LetStmtNode &node) const {
-  return fmt::format("Let({}, {})", node.var_name, node.var_type);
+  return fmt::format("Let({}, {})", node.var_name.str(),
+                     node.var_type.str());
 }
 
 std::string ASTPrinter::operator()(const AssignmentStmtNode &node) const {
-  return fmt::format("Assign({}, {})", node.var_name,
+  return fmt::format("Assign({}, {})", node.var_name.str(),
                      std::visit(*this, node.assign_expr));
 }
 
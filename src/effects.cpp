@@ -0,0 +1,424 @@
+#include "effects.h"
+#include "ast.h"
+#include "flat_ast.h"
+#include "ops.h"
+#include "range.h"
+#include "symbol.h"
+#include "types.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+
+#include <fmt/core.h>
+
+namespace stapl::analysis {
+namespace {
+/**
+ * @brief Call graph of a module, with one node per function name.
+ */
+struct CallGraph {
+  /**
+   * @brief A function of the call graph.
+   */
+  struct Node {
+    /**
+     * @brief Name of the function.
+     */
+    util::Symbol name;
+
+    /**
+     * @brief Whether any declaration of the name has a body.
+     */
+    bool defined = false;
+
+    /**
+     * @brief Whether any declaration of the name is an extern function.
+     */
+    bool is_extern = false;
+
+    /**
+     * @brief Whether the body of the function has a loop.
+     */
+    bool has_loop = false;
+
+    /**
+     * @brief Whether the body of the function has a division which may trap.
+     */
+    bool may_trap = false;
+
+    /**
+     * @brief Indices of the called functions.
+     */
+    std::vector<std::size_t> callees;
+  };
+
+  /**
+   * @brief Functions, in order of first appearance.
+   */
+  std::vector<Node> nodes;
+
+  /**
+   * @brief Mapping from function names to indices in ``nodes``.
+   */
+  std::unordered_map<util::Symbol, std::size_t> indices;
+
+  /**
+   * @brief Whether integer division traps on a zero divisor or overflow.
+   */
+  bool checked_division;
+
+  /**
+   * @brief Ranges of the expressions, if they were analyzed.
+   */
+  const RangeFacts *ranges;
+
+  CallGraph(bool checked_division, const RangeFacts *ranges)
+      : checked_division(checked_division), ranges(ranges) {}
+
+  std::size_t node(util::Symbol name) {
+    auto [it, inserted] = indices.try_emplace(name, nodes.size());
+    if (inserted)
+      nodes.push_back({name});
+    return it->second;
+  }
+
+  void declare(const ast::PrototypeNode &proto, bool has_body) {
+    auto &func = nodes[node(proto.name)];
+    if (has_body)
+      func.defined = true;
+    else
+      func.is_extern = true;
+  }
+
+  void add_call(std::size_t caller, util::Symbol callee) {
+    auto index = node(callee);
+    nodes[caller].callees.push_back(index);
+  }
+
+  void add_division(std::size_t caller, const Interval &lhs,
+                    const Interval &rhs) {
+    if (checked_division && division_may_trap(lhs, rhs))
+      nodes[caller].may_trap = true;
+  }
+
+  static bool is_division(ast::Op op) {
+    return op == ast::Op::Div || op == ast::Op::Mod;
+  }
+};
+
+class TreeCallCollector {
+private:
+  CallGraph &graph;
+
+  std::size_t caller;
+
+public:
+  TreeCallCollector(CallGraph &graph, std::size_t caller)
+      : graph(graph), caller(caller) {}
+
+  template <typename T> void operator()(const ast::LiteralExprNode<T> &node) {}
+
+  void operator()(const ast::VariableExprNode &node) {}
+
+  void operator()(const std::unique_ptr<ast::UnaryExprNode> &node) {
+    std::visit(*this, node->rhs);
+  }
+
+  void operator()(const std::unique_ptr<ast::BinaryExprNode> &node) {
+    if (CallGraph::is_division(node->op) &&
+        node->expr_type == types::int_type) {
+      if (graph.ranges == nullptr)
+        graph.add_division(caller, {}, {});
+      else
+        graph.add_division(caller,
+                           graph.ranges->range(expr_key(node->lhs)),
+                           graph.ranges->range(expr_key(node->rhs)));
+    }
+    std::visit(*this, node->lhs);
+    std::visit(*this, node->rhs);
+  }
+
+  void operator()(const std::unique_ptr<ast::CallExprNode> &node) {
+    graph.add_call(caller, node->callee);
+    for (const auto &arg : node->args)
+      std::visit(*this, arg);
+  }
+
+  void operator()(const ast::LetStmtNode &node) {}
+
+  void operator()(const ast::AssignmentStmtNode &node) {
+    std::visit(*this, node.assign_expr);
+  }
+
+  void operator()(const std::unique_ptr<ast::IfStmtNode> &node) {
+    std::visit(*this, node->condition);
+    std::visit(*this, node->then_stmt);
+    std::visit(*this, node->else_stmt);
+  }
+
+  void operator()(const std::unique_ptr<ast::WhileStmtNode> &node) {
+    graph.nodes[caller].has_loop = true;
+    std::visit(*this, node->condition);
+    std::visit(*this, node->body);
+  }
+
+  void operator()(const ast::BreakStmtNode &node) {}
+
+  void operator()(const ast::ContinueStmtNode &node) {}
+
+  void operator()(const ast::ReturnStmtNode &node) {
+    std::visit(*this, node.return_expr);
+  }
+
+  void operator()(const std::unique_ptr<ast::CompoundStmtNode> &node) {
+    for (const auto &stmt : node->stmts)
+      std::visit(*this, stmt);
+  }
+};
+
+void collect_flat_calls(CallGraph &graph, std::size_t caller,
+                        const ast::FlatModule &module, ast::IndexRange range) {
+  const auto &exprs = module.exprs;
+  for (auto i = range.begin; i < range.end; i++) {
+    if (exprs.kinds[i] == ast::FlatExprKind::Call)
+      graph.add_call(caller, util::Symbol::from_id(exprs.payloads[i]));
+    if (exprs.kinds[i] != ast::FlatExprKind::Binary ||
+        !CallGraph::is_division(static_cast<ast::Op>(exprs.payloads[i])) ||
+        exprs.types[i] != types::int_type)
+      continue;
+    if (graph.ranges == nullptr) {
+      graph.add_division(caller, {}, {});
+      continue;
+    }
+    auto lhs = exprs.subtree_begins[i - 1] - 1;
+    graph.add_division(caller, graph.ranges->flat_range(lhs),
+                       graph.ranges->flat_range(i - 1));
+  }
+}
+
+void collect_flat_calls(CallGraph &graph, std::size_t caller,
+                        const ast::FlatModule &module, ast::FlatStmtRef stmt) {
+  switch (stmt.kind) {
+  case ast::FlatStmtKind::Let:
+  case ast::FlatStmtKind::Break:
+  case ast::FlatStmtKind::Continue:
+    break;
+  case ast::FlatStmtKind::Assignment:
+    collect_flat_calls(graph, caller, module,
+                       module.assignments[stmt.index].assign_expr);
+    break;
+  case ast::FlatStmtKind::If: {
+    const auto &if_stmt = module.ifs[stmt.index];
+    collect_flat_calls(graph, caller, module, if_stmt.condition);
+    collect_flat_calls(graph, caller, module, if_stmt.then_stmt);
+    collect_flat_calls(graph, caller, module, if_stmt.else_stmt);
+    break;
+  }
+  case ast::FlatStmtKind::While: {
+    const auto &while_stmt = module.whiles[stmt.index];
+    graph.nodes[caller].has_loop = true;
+    collect_flat_calls(graph, caller, module, while_stmt.condition);
+    collect_flat_calls(graph, caller, module, while_stmt.body);
+    break;
+  }
+  case ast::FlatStmtKind::Return:
+    collect_flat_calls(graph, caller, module,
+                       module.returns[stmt.index].return_expr);
+    break;
+  case ast::FlatStmtKind::Compound: {
+    auto range = module.compounds[stmt.index].stmts;
+    for (auto i = range.begin; i < range.end; i++)
+      collect_flat_calls(graph, caller, module, module.stmt_lists[i]);
+    break;
+  }
+  }
+}
+
+/**
+ * @brief Tarjan's algorithm for the strongly connected components of a call
+ * graph.
+ */
+class ComponentFinder {
+private:
+  static constexpr std::size_t unvisited =
+      std::numeric_limits<std::size_t>::max();
+
+  const CallGraph &graph;
+
+  std::vector<std::size_t> order, low_links;
+
+  std::vector<bool> on_stack;
+
+  std::vector<std::size_t> stack;
+
+  std::size_t next_order = 0;
+
+  void visit(std::size_t index) {
+    order[index] = low_links[index] = next_order++;
+    stack.push_back(index);
+    on_stack[index] = true;
+    for (auto callee : graph.nodes[index].callees) {
+      if (order[callee] == unvisited) {
+        visit(callee);
+        low_links[index] = std::min(low_links[index], low_links[callee]);
+      } else if (on_stack[callee])
+        low_links[index] = std::min(low_links[index], order[callee]);
+    }
+    if (low_links[index] != order[index])
+      return;
+
+    auto &component = components.emplace_back();
+    std::size_t member;
+    do {
+      member = stack.back();
+      stack.pop_back();
+      on_stack[member] = false;
+      component.push_back(member);
+    } while (member != index);
+  }
+
+public:
+  /**
+   * @brief Components, each of which comes after the components it calls.
+   */
+  std::vector<std::vector<std::size_t>> components;
+
+  explicit ComponentFinder(const CallGraph &graph)
+      : graph(graph), order(graph.nodes.size(), unvisited),
+        low_links(graph.nodes.size()), on_stack(graph.nodes.size()) {
+    for (std::size_t i = 0; i < graph.nodes.size(); i++)
+      if (order[i] == unvisited)
+        visit(i);
+  }
+};
+
+EffectFacts propagate_effects(const CallGraph &graph) {
+  EffectFacts facts;
+  facts.functions.resize(graph.nodes.size());
+  ComponentFinder finder(graph);
+  std::vector<std::size_t> component_of(graph.nodes.size());
+  for (std::size_t i = 0; i < finder.components.size(); i++)
+    for (auto member : finder.components[i])
+      component_of[member] = i;
+
+  for (std::size_t i = 0; i < finder.components.size(); i++) {
+    const auto &component = finder.components[i];
+    bool recursive = component.size() > 1, is_extern = false, has_loop = false,
+         may_trap = false;
+    bool callees_no_recurse = true, callees_no_unwind = true,
+         callees_will_return = true;
+    auto purity = Purity::Pure;
+    for (auto member : component) {
+      const auto &node = graph.nodes[member];
+      // Undeclared functions are unknown, so they are treated like externs.
+      if (node.is_extern || !node.defined) {
+        is_extern = true;
+        purity = Purity::Effectful;
+      }
+      has_loop = has_loop || node.has_loop;
+      may_trap = may_trap || node.may_trap;
+      for (auto callee : node.callees) {
+        if (component_of[callee] == i) {
+          recursive = true;
+          continue;
+        }
+        const auto &effects = facts.functions[callee];
+        purity = std::max(purity, effects.purity);
+        callees_no_recurse = callees_no_recurse && effects.no_recurse;
+        callees_no_unwind = callees_no_unwind && effects.no_unwind;
+        callees_will_return = callees_will_return && effects.will_return;
+        may_trap = may_trap || effects.may_trap;
+      }
+    }
+
+    for (auto member : component) {
+      auto &effects = facts.functions[member];
+      effects.name = graph.nodes[member].name;
+      effects.purity = purity;
+      effects.is_extern = graph.nodes[member].is_extern;
+      effects.recursive = recursive;
+      effects.no_recurse = !recursive && !is_extern && callees_no_recurse;
+      effects.no_unwind = !is_extern && callees_no_unwind;
+      effects.may_trap = may_trap;
+      effects.will_return =
+          effects.no_recurse && !has_loop && !may_trap && callees_will_return;
+    }
+  }
+  facts.indices = graph.indices;
+  return facts;
+}
+} // namespace
+
+std::string_view purity_name(Purity purity) {
+  switch (purity) {
+  case Purity::Pure:
+    return "pure";
+  case Purity::ReadOnly:
+    return "read-only";
+  default:
+    return "effectful";
+  }
+}
+
+const FunctionEffects *EffectFacts::find(util::Symbol name) const {
+  auto it = indices.find(name);
+  return it != indices.end() ? &functions[it->second] : nullptr;
+}
+
+EffectFacts analyze_effects(const ast::Module &module, bool checked_division,
+                            const RangeFacts *ranges) {
+  CallGraph graph(checked_division, ranges);
+  for (const auto &decl : module.decls) {
+    const auto &func = std::get<ast::FunctionDeclNode>(decl);
+    graph.declare(func.proto, func.func_body.has_value());
+  }
+  for (const auto &decl : module.decls) {
+    const auto &func = std::get<ast::FunctionDeclNode>(decl);
+    if (func.func_body.has_value())
+      std::visit(TreeCallCollector(graph, graph.node(func.proto.name)),
+                 func.func_body.value());
+  }
+  return propagate_effects(graph);
+}
+
+EffectFacts analyze_effects(const ast::FlatModule &module,
+                            bool checked_division, const RangeFacts *ranges) {
+  CallGraph graph(checked_division, ranges);
+  for (const auto &func : module.functions)
+    graph.declare(func.proto, func.func_body.has_value());
+  for (const auto &func : module.functions)
+    if (func.func_body.has_value())
+      collect_flat_calls(graph, graph.node(func.proto.name), module,
+                         func.func_body.value());
+  return propagate_effects(graph);
+}
+
+std::string effects_report(const EffectFacts &facts) {
+  std::string report;
+  for (const auto &effects : facts.functions) {
+    report += fmt::format("{}: {}", effects.name.str(),
+                          purity_name(effects.purity));
+    if (effects.is_extern)
+      report += ", extern";
+    if (effects.recursive)
+      report += ", recursive";
+    if (effects.no_recurse)
+      report += ", norecurse";
+    if (effects.no_unwind)
+      report += ", nounwind";
+    if (effects.will_return)
+      report += ", willreturn";
+    if (effects.may_trap)
+      report += ", may trap";
+    report += '\n';
+  }
+  return report;
+}
+} // namespace stapl::analysis
@@ -0,0 +1,189 @@
+#include "flat_ast.h"
+#include "ast.h"
+#include "symbol.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace stapl::ast {
+namespace {
+NodeIndex to_index(std::size_t size) {
+  if (size > std::numeric_limits<NodeIndex>::max())
+    throw std::logic_error("too many nodes for flat module");
+  return static_cast<NodeIndex>(size);
+}
+
+class Flattener {
+private:
+  FlatModule &module;
+
+  NodeIndex push_expr(FlatExprKind kind, std::uint32_t payload,
+                      NodeIndex arity, NodeIndex subtree_begin) {
+    auto &exprs = module.exprs;
+    NodeIndex index = to_index(exprs.size());
+    exprs.kinds.push_back(kind);
+    exprs.payloads.push_back(payload);
+    exprs.arities.push_back(arity);
+    exprs.subtree_begins.push_back(subtree_begin);
+    exprs.types.emplace_back();
+    return index;
+  }
+
+  template <typename T>
+  FlatStmtRef push_stmt(FlatStmtKind kind, std::vector<T> &pool, T stmt) {
+    NodeIndex index = to_index(pool.size());
+    pool.push_back(std::move(stmt));
+    return {kind, index};
+  }
+
+public:
+  explicit Flattener(FlatModule &module) : module(module) {}
+
+  IndexRange flatten_expr(const ExprNode &node) {
+    auto begin = to_index(module.exprs.size());
+    std::visit(*this, node);
+    return {begin, to_index(module.exprs.size())};
+  }
+
+  void operator()(const LiteralExprNode<int> &node) {
+    push_expr(FlatExprKind::Int, std::bit_cast<std::uint32_t>(node.value), 0,
+              to_index(module.exprs.size()));
+  }
+
+  void operator()(const LiteralExprNode<double> &node) {
+    auto float_index = to_index(module.exprs.floats.size());
+    module.exprs.floats.push_back(node.value);
+    push_expr(FlatExprKind::Float, float_index, 0,
+              to_index(module.exprs.size()));
+  }
+
+  void operator()(const LiteralExprNode<bool> &node) {
+    push_expr(FlatExprKind::Bool, node.value, 0, to_index(module.exprs.size()));
+  }
+
+  void operator()(const VariableExprNode &node) {
+    push_expr(FlatExprKind::Variable, node.name.id(), 0,
+              to_index(module.exprs.size()));
+  }
+
+  void operator()(const std::unique_ptr<UnaryExprNode> &node) {
+    auto rhs = flatten_expr(node->rhs);
+    push_expr(FlatExprKind::Unary, static_cast<std::uint32_t>(node->op), 1,
+              rhs.begin);
+  }
+
+  void operator()(const std::unique_ptr<BinaryExprNode> &node) {
+    auto lhs = flatten_expr(node->lhs);
+    flatten_expr(node->rhs);
+    push_expr(FlatExprKind::Binary, static_cast<std::uint32_t>(node->op), 2,
+              lhs.begin);
+  }
+
+  void operator()(const std::unique_ptr<CallExprNode> &node) {
+    auto begin = to_index(module.exprs.size());
+    for (const auto &arg : node->args)
+      flatten_expr(arg);
+    push_expr(FlatExprKind::Call, node->callee.id(),
+              to_index(node->args.size()), begin);
+  }
+
+  FlatStmtRef flatten_stmt(const StmtNode &node) {
+    return std::visit(*this, node);
+  }
+
+  FlatStmtRef operator()(const LetStmtNode &node) {
+    return push_stmt(FlatStmtKind::Let, module.lets,
+                     {node.var_name, node.var_type});
+  }
+
+  FlatStmtRef operator()(const AssignmentStmtNode &node) {
+    return push_stmt(FlatStmtKind::Assignment, module.assignments,
+                     {node.var_name, flatten_expr(node.assign_expr)});
+  }
+
+  FlatStmtRef operator()(const std::unique_ptr<IfStmtNode> &node) {
+    auto condition = flatten_expr(node->condition);
+    auto then_stmt = flatten_stmt(node->then_stmt);
+    auto else_stmt = flatten_stmt(node->else_stmt);
+    return push_stmt(FlatStmtKind::If, module.ifs,
+                     {condition, then_stmt, else_stmt});
+  }
+
+  FlatStmtRef operator()(const std::unique_ptr<WhileStmtNode> &node) {
+    auto condition = flatten_expr(node->condition);
+    auto body = flatten_stmt(node->body);
+    return push_stmt(FlatStmtKind::While, module.whiles, {condition, body});
+  }
+
+  FlatStmtRef operator()(const BreakStmtNode &node) {
+    return {FlatStmtKind::Break, 0};
+  }
+
+  FlatStmtRef operator()(const ContinueStmtNode &node) {
+    return {FlatStmtKind::Continue, 0};
+  }
+
+  FlatStmtRef operator()(const ReturnStmtNode &node) {
+    return push_stmt(FlatStmtKind::Return, module.returns,
+                     {flatten_expr(node.return_expr)});
+  }
+
+  FlatStmtRef operator()(const std::unique_ptr<CompoundStmtNode> &node) {
+    // Nested compound statements append to `stmt_lists` too, so the children
+    // are collected first to keep them contiguous.
+    std::vector<FlatStmtRef> stmts;
+    stmts.reserve(node->stmts.size());
+    for (const auto &stmt : node->stmts)
+      stmts.push_back(flatten_stmt(stmt));
+    auto begin = to_index(module.stmt_lists.size());
+    module.stmt_lists.insert(module.stmt_lists.end(), stmts.begin(),
+                             stmts.end());
+    return push_stmt(FlatStmtKind::Compound, module.compounds,
+                     {{begin, to_index(module.stmt_lists.size())}});
+  }
+
+  void operator()(const FunctionDeclNode &node) {
+    std::optional<FlatStmtRef> func_body;
+    if (node.func_body.has_value())
+      func_body = flatten_stmt(node.func_body.value());
+    module.functions.push_back(
+        {PrototypeNode(node.proto.name, node.proto.args,
+                       node.proto.return_type),
+         func_body});
+  }
+};
+} // namespace
+
+std::size_t FlatExprPool::size() const { return kinds.size(); }
+
+IndexRange FlatExprPool::subtree(NodeIndex index) const {
+  return {subtree_begins[index], index + 1};
+}
+
+std::vector<NodeIndex> FlatExprPool::children(NodeIndex index) const {
+  std::vector<NodeIndex> result(arities[index]);
+  NodeIndex child = index;
+  for (auto it = result.rbegin(); it != result.rend(); it++) {
+    *it = --child;
+    child = subtree_begins[child];
+  }
+  return result;
+}
+
+FlatModule flatten(const Module &module) {
+  FlatModule flat_module;
+  flat_module.name = module.name;
+  Flattener flattener(flat_module);
+  for (const auto &decl : module.decls)
+    std::visit(flattener, decl);
+  return flat_module;
+}
+} // namespace stapl::ast
@@ -1,38 +1,59 @@
 #include "irgen.h"
 #include "ast.h"
-
+#include "effects.h"
+#include "flat_ast.h"
+#include "ops.h"
+#include "range.h"
+#include "symbol.h"
+#include "types.h"
+
+#include <array>
+#include <cstddef>
 #include <cstdint>
+#include <limits>
 #include <memory>
 #include <ostream>
 #include <stdexcept>
 #include <string>
+#include <system_error>
+#include <utility>
 #include <variant>
 #include <vector>
 
 #include <llvm/ADT/APFloat.h>
 #include <llvm/ADT/APInt.h>
+#include <llvm/ADT/STLFunctionalExtras.h>
+#include <llvm/Bitcode/BitcodeWriter.h>
 #include <llvm/IR/BasicBlock.h>
 #include <llvm/IR/Constant.h>
 #include <llvm/IR/Constants.h>
 #include <llvm/IR/Function.h>
 #include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/InstrTypes.h>
+#include <llvm/IR/Intrinsics.h>
 #include <llvm/IR/Instructions.h>
 #include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/MDBuilder.h>
 #include <llvm/IR/Module.h>
+#include <llvm/IR/Operator.h>
 #include <llvm/IR/Type.h>
 #include <llvm/IR/Value.h>
 #include <llvm/IR/Verifier.h>
+#include <llvm/Support/FileSystem.h>
 #include <llvm/Support/raw_os_ostream.h>
+#include <llvm/Support/raw_ostream.h>
 
 #include <fmt/core.h>
 
 namespace stapl::ir {
-IRGen::IRGen()
+IRGen::IRGen(const IRGenOptions &options)
     : context(new llvm::LLVMContext()), module(new llvm::Module("", *context)),
-      builder(new llvm::IRBuilder<>(*context)) {}
+      builder(new llvm::IRBuilder<>(*context)), options(options) {}
 
 void IRGen::codegen(ast::Module &module_node) {
   module->setModuleIdentifier(module_node.name);
+  for (auto &decl : module_node.decls)
+    declare_function(std::get<ast::FunctionDeclNode>(decl).proto);
   for (auto &decl : module_node.decls)
     std::visit(*this, decl);
 }
@@ -42,6 +63,32 @@ void IRGen::write_ir(std::ostream &os) {
   module->print(out_stream, nullptr);
 }
 
+void IRGen::write_ir(const std::string &path) {
+  std::error_code ec;
+  llvm::raw_fd_ostream out_stream(path, ec, llvm::sys::fs::OF_Text);
+  if (ec)
+    throw std::logic_error(
+        fmt::format("cannot open output file {}: {}", path, ec.message()));
+  module->print(out_stream, nullptr);
+}
+
+void IRGen::write_bitcode(const std::string &path) {
+  std::error_code ec;
+  llvm::raw_fd_ostream out_stream(path, ec, llvm::sys::fs::OF_None);
+  if (ec)
+    throw std::logic_error(
+        fmt::format("cannot open output file {}: {}", path, ec.message()));
+  llvm::WriteBitcodeToFile(*module, out_stream);
+}
+
+llvm::Module &IRGen::get_module() { return *module; }
+
+std::pair<std::unique_ptr<llvm::LLVMContext>, std::unique_ptr<llvm::Module>>
+IRGen::release_module() {
+  builder.reset();
+  return {std::move(context), std::move(module)};
+}
+
 llvm::Value *IRGen::unary_op_pos(llvm::Value *rhs_val) { return rhs_val; }
 
 llvm::Value *IRGen::unary_op_neg(llvm::Value *rhs_val) {
@@ -85,13 +132,8 @@ llvm::Value *IRGen::binary_op_mul(llvm::Value *lhs_val, llvm::Value *rhs_val) {
 llvm::Value *IRGen::binary_op_div(llvm::Value *lhs_val, llvm::Value *rhs_val) {
   if (lhs_val->getType()->isDoubleTy() && rhs_val->getType()->isDoubleTy())
     return builder->CreateFDiv(lhs_val, rhs_val);
-  if (lhs_val->getType()->isIntegerTy() && rhs_val->getType()->isIntegerTy()) {
-    llvm::Value *lhs_casted_val, *rhs_casted_val, *div_fp;
-    lhs_casted_val = builder->CreateSIToFP(lhs_val, builder->getDoubleTy());
-    rhs_casted_val = builder->CreateSIToFP(rhs_val, builder->getDoubleTy());
-    div_fp = builder->CreateFDiv(lhs_casted_val, rhs_casted_val);
-    return builder->CreateFPToSI(div_fp, builder->getInt32Ty());
-  }
+  if (lhs_val->getType()->isIntegerTy() && rhs_val->getType()->isIntegerTy())
+    return builder->CreateSDiv(lhs_val, rhs_val);
   throw std::logic_error("unknown type signature");
 }
 
@@ -163,8 +205,11 @@ llvm::Value *IRGen::operator()(ast::LiteralExprNode<bool> &node) {
 }
 
 llvm::Value *IRGen::operator()(ast::VariableExprNode &node) {
-  llvm::AllocaInst *alloc = current_scope_symbols.at(node.name);
-  return builder->CreateLoad(alloc->getAllocatedType(), alloc);
+  llvm::AllocaInst *alloc = get_variable(node.name);
+  auto load = builder->CreateLoad(alloc->getAllocatedType(), alloc);
+  if (range_facts != nullptr)
+    set_range_metadata(load, range_facts->range(&node));
+  return load;
 }
 
 llvm::AllocaInst *IRGen::create_entry_block_alloc(llvm::Function *func,
@@ -175,30 +220,160 @@ llvm::AllocaInst *IRGen::create_entry_block_alloc(llvm::Function *func,
   return tmp_block.CreateAlloca(type, nullptr, name);
 }
 
-llvm::Type *IRGen::type_from_typename(const std::string &name) {
-  if (name == "int")
-    return builder->getInt32Ty();
-  else if (name == "float")
-    return builder->getDoubleTy();
-  else if (name == "bool")
-    return builder->getInt1Ty();
-  else if (name == "void")
-    return builder->getVoidTy();
-  throw std::logic_error(fmt::format("unknown type: {}", name));
+llvm::Type *IRGen::get_llvm_type(types::TypeId type) {
+  if (type.id() < llvm_types.size() && llvm_types[type.id()] != nullptr)
+    return llvm_types[type.id()];
+
+  llvm::Type *llvm_type;
+  switch (type.kind()) {
+  case types::TypeKind::Int:
+    llvm_type = builder->getInt32Ty();
+    break;
+  case types::TypeKind::Float:
+    llvm_type = builder->getDoubleTy();
+    break;
+  case types::TypeKind::Bool:
+    llvm_type = builder->getInt1Ty();
+    break;
+  case types::TypeKind::Void:
+    llvm_type = builder->getVoidTy();
+    break;
+  default:
+    throw std::logic_error(fmt::format("unknown type: {}", type.str()));
+  }
+  if (type.id() >= llvm_types.size())
+    llvm_types.resize(type.id() + 1);
+  llvm_types[type.id()] = llvm_type;
+  return llvm_type;
+}
+
+const std::array<IRGen::UnaryBuilder, ast::num_ops> IRGen::unary_builders =
+    [] {
+      std::array<UnaryBuilder, ast::num_ops> table{};
+      table[static_cast<std::size_t>(ast::Op::Add)] = &IRGen::unary_op_pos;
+      table[static_cast<std::size_t>(ast::Op::Sub)] = &IRGen::unary_op_neg;
+      table[static_cast<std::size_t>(ast::Op::Not)] = &IRGen::unary_op_not;
+      return table;
+    }();
+
+const std::array<IRGen::BinaryBuilder, ast::num_ops> IRGen::binary_builders =
+    {&IRGen::binary_op_add, &IRGen::binary_op_sub, &IRGen::binary_op_mul,
+     &IRGen::binary_op_div, &IRGen::binary_op_mod, &IRGen::binary_op_eq,
+     &IRGen::binary_op_neq, &IRGen::binary_op_lt,  &IRGen::binary_op_gt,
+     &IRGen::binary_op_le,  &IRGen::binary_op_ge,  nullptr};
+
+llvm::Value *IRGen::unary_op(ast::Op op, llvm::Value *rhs_val) {
+  auto builder_func = unary_builders[static_cast<std::size_t>(op)];
+  if (builder_func == nullptr)
+    throw std::logic_error(
+        fmt::format("unknown unary operator: {}", ast::op_text(op)));
+  return (this->*builder_func)(rhs_val);
+}
+
+llvm::Value *IRGen::binary_op(ast::Op op, llvm::Value *lhs_val,
+                              llvm::Value *rhs_val,
+                              const analysis::Interval &lhs_range,
+                              const analysis::Interval &rhs_range) {
+  auto builder_func = binary_builders[static_cast<std::size_t>(op)];
+  if (builder_func == nullptr)
+    throw std::logic_error(
+        fmt::format("unknown binary operator: {}", ast::op_text(op)));
+  if ((op == ast::Op::Div || op == ast::Op::Mod) &&
+      options.int_div == IntDivPolicy::Trap &&
+      lhs_val->getType()->isIntegerTy() && rhs_val->getType()->isIntegerTy())
+    emit_division_check(lhs_val, rhs_val, lhs_range, rhs_range);
+  auto result = (this->*builder_func)(lhs_val, rhs_val);
+  set_wrap_flags(result, analysis::wrap_flags(op, lhs_range, rhs_range));
+  return result;
+}
+
+void IRGen::emit_division_check(llvm::Value *lhs_val, llvm::Value *rhs_val,
+                                const analysis::Interval &lhs_range,
+                                const analysis::Interval &rhs_range) {
+  auto int_min = std::numeric_limits<std::int32_t>::min();
+  llvm::Value *invalid = nullptr;
+  if (rhs_range.contains(0))
+    invalid = builder->CreateICmpEQ(rhs_val, builder->getInt32(0));
+  if (lhs_range.contains(int_min) && rhs_range.contains(-1)) {
+    auto overflow = builder->CreateAnd(
+        builder->CreateICmpEQ(lhs_val, builder->getInt32(int_min)),
+        builder->CreateICmpEQ(rhs_val, builder->getInt32(-1)));
+    invalid = invalid != nullptr ? builder->CreateOr(invalid, overflow)
+                                 : overflow;
+  }
+  if (invalid == nullptr)
+    return;
+
+  llvm::Function *current_func = builder->GetInsertBlock()->getParent();
+  llvm::BasicBlock *trap_block =
+      llvm::BasicBlock::Create(*context, "div.trap", current_func);
+  llvm::BasicBlock *cont_block =
+      llvm::BasicBlock::Create(*context, "div.cont", current_func);
+  // The weights MDBuilder::createUnlikelyBranchWeights of later LLVM uses.
+  auto weights =
+      llvm::MDBuilder(*context).createBranchWeights(1, (1U << 20) - 1);
+  builder->CreateCondBr(invalid, trap_block, cont_block, weights);
+  builder->SetInsertPoint(trap_block);
+  builder->CreateCall(
+      llvm::Intrinsic::getDeclaration(module.get(), llvm::Intrinsic::trap));
+  builder->CreateUnreachable();
+  builder->SetInsertPoint(cont_block);
+}
+
+void IRGen::set_wrap_flags(llvm::Value *value, analysis::WrapFlags flags) {
+  auto inst = llvm::dyn_cast<llvm::BinaryOperator>(value);
+  if (inst == nullptr)
+    return;
+  if (llvm::isa<llvm::OverflowingBinaryOperator>(inst)) {
+    if (flags.nsw)
+      inst->setHasNoSignedWrap();
+    if (flags.nuw)
+      inst->setHasNoUnsignedWrap();
+  }
+  if (llvm::isa<llvm::PossiblyExactOperator>(inst) && flags.exact)
+    inst->setIsExact();
+}
+
+void IRGen::set_range_metadata(llvm::LoadInst *load,
+                               const analysis::Interval &range) {
+  if (range.is_full() || !load->getType()->isIntegerTy(32))
+    return;
+  // The upper bound of ``!range`` is exclusive and wraps around at the top of
+  // the type.
+  auto lo = static_cast<std::int32_t>(range.lo),
+       hi = static_cast<std::int32_t>(static_cast<std::uint32_t>(range.hi + 1));
+  load->setMetadata(llvm::LLVMContext::MD_range,
+                    llvm::MDBuilder(*context).createRange(
+                        llvm::APInt(32, static_cast<std::uint64_t>(lo), true),
+                        llvm::APInt(32, static_cast<std::uint64_t>(hi), true)));
+}
+
+void IRGen::set_range_facts(const analysis::RangeFacts &facts) {
+  range_facts = &facts;
+}
+
+llvm::Function *IRGen::get_callee(util::Symbol callee, std::size_t arg_count) {
+  auto callee_func = module->getFunction(callee.str());
+  if (callee_func == nullptr)
+    throw std::logic_error(fmt::format("unknown function: {}", callee.str()));
+  if (callee_func->arg_size() != arg_count)
+    throw std::logic_error(
+        fmt::format("arg count mismatch: expected {} args, got {} args",
+                    callee_func->arg_size(), arg_count));
+  return callee_func;
 }
 
 llvm::Value *IRGen::operator()(std::unique_ptr<ast::UnaryExprNode> &node) {
   auto rhs_val = std::visit(*this, node->rhs);
   if (rhs_val == nullptr)
     throw std::logic_error("failed to codegen for rhs");
-
-  if (node->op == "+")
-    return unary_op_pos(rhs_val);
-  else if (node->op == "-")
-    return unary_op_neg(rhs_val);
-  else if (node->op == "!")
-    return unary_op_not(rhs_val);
-  throw std::logic_error(fmt::format("unknown unary operator: {}", node->op));
+  auto result = unary_op(node->op, rhs_val);
+  // Negation is a subtraction from zero.
+  if (range_facts != nullptr && node->op == ast::Op::Sub) {
+    auto rhs = range_facts->range(analysis::expr_key(node->rhs));
+    set_wrap_flags(result, analysis::wrap_flags(ast::Op::Sub, {0, 0}, rhs));
+  }
+  return result;
 }
 
 llvm::Value *IRGen::operator()(std::unique_ptr<ast::BinaryExprNode> &node) {
@@ -208,40 +383,15 @@ llvm::Value *IRGen::operator()(std::unique_ptr<ast::BinaryExprNode> &node) {
     throw std::logic_error("failed to codegen for lhs");
   if (rhs_val == nullptr)
     throw std::logic_error("failed to codegen for rhs");
-
-  if (node->op == "+")
-    return binary_op_add(lhs_val, rhs_val);
-  else if (node->op == "-")
-    return binary_op_sub(lhs_val, rhs_val);
-  else if (node->op == "*")
-    return binary_op_mul(lhs_val, rhs_val);
-  else if (node->op == "/")
-    return binary_op_div(lhs_val, rhs_val);
-  else if (node->op == "%")
-    return binary_op_mod(lhs_val, rhs_val);
-  else if (node->op == "==")
-    return binary_op_eq(lhs_val, rhs_val);
-  else if (node->op == "!=")
-    return binary_op_neq(lhs_val, rhs_val);
-  else if (node->op == "<")
-    return binary_op_lt(lhs_val, rhs_val);
-  else if (node->op == ">")
-    return binary_op_gt(lhs_val, rhs_val);
-  else if (node->op == "<=")
-    return binary_op_le(lhs_val, rhs_val);
-  else if (node->op == ">=")
-    return binary_op_ge(lhs_val, rhs_val);
-  throw std::logic_error(fmt::format("unknown binary operator: {}", node->op));
+  if (range_facts == nullptr)
+    return binary_op(node->op, lhs_val, rhs_val);
+  return binary_op(node->op, lhs_val, rhs_val,
+                   range_facts->range(analysis::expr_key(node->lhs)),
+                   range_facts->range(analysis::expr_key(node->rhs)));
 }
 
 llvm::Value *IRGen::operator()(std::unique_ptr<ast::CallExprNode> &node) {
-  auto callee_func = module->getFunction(node->callee);
-  if (callee_func == nullptr)
-    throw std::logic_error(fmt::format("unknown function: {}", node->callee));
-  if (callee_func->arg_size() != node->args.size())
-    throw std::logic_error(
-        fmt::format("arg count mismatch: expected {} args, got {} args",
-                    callee_func->arg_size(), node->args.size()));
+  auto callee_func = get_callee(node->callee, node->args.size());
   std::vector<llvm::Value *> arg_vals;
   for (auto &arg : node->args) {
     auto arg_val = std::visit(*this, arg);
@@ -250,33 +400,46 @@ llvm::Value *IRGen::operator()(std::unique_ptr<ast::CallExprNode> &node) {
   return builder->CreateCall(callee_func, arg_vals);
 }
 
-void IRGen::operator()(ast::LetStmtNode &node) {
+void IRGen::emit_let(util::Symbol var_name, types::TypeId var_type) {
   llvm::Function *current_func = builder->GetInsertBlock()->getParent();
   llvm::Value *init_val;
-  llvm::Type *var_type_ir;
-  if (node.var_type == "int") {
+  if (var_type == types::int_type)
     init_val = llvm::ConstantInt::get(
         *context, llvm::APInt(32, static_cast<uint64_t>(0), true));
-    var_type_ir = builder->getInt32Ty();
-  } else if (node.var_type == "float") {
+  else if (var_type == types::float_type)
     init_val = llvm::ConstantFP::get(*context, llvm::APFloat(0.0));
-    var_type_ir = builder->getDoubleTy();
-  } else
-    throw std::logic_error(fmt::format("unknown type: {}", node.var_type));
+  else
+    throw std::logic_error(fmt::format("unknown type: {}", var_type.str()));
+  llvm::Type *var_type_ir = get_llvm_type(var_type);
   llvm::AllocaInst *alloc =
-      create_entry_block_alloc(current_func, node.var_name, var_type_ir);
+      create_entry_block_alloc(current_func, var_name.str(), var_type_ir);
   builder->CreateStore(init_val, alloc);
-  current_scope_symbols[node.var_name] = alloc;
+  if (!variables.define(var_name, alloc))
+    throw std::logic_error(
+        fmt::format("redefinition of variable {}", var_name.str()));
+}
+
+llvm::AllocaInst *IRGen::get_variable(util::Symbol name) const {
+  llvm::AllocaInst *const *alloc = variables.lookup(name);
+  if (alloc == nullptr)
+    throw std::logic_error(fmt::format("unknown variable: {}", name.str()));
+  return *alloc;
+}
+
+void IRGen::operator()(ast::LetStmtNode &node) {
+  emit_let(node.var_name, node.var_type);
 }
 
 void IRGen::operator()(ast::AssignmentStmtNode &node) {
   llvm::Value *rhs_val = std::visit(*this, node.assign_expr),
-              *lhs_val = current_scope_symbols.at(node.var_name);
+              *lhs_val = get_variable(node.var_name);
   builder->CreateStore(rhs_val, lhs_val);
 }
 
-void IRGen::operator()(std::unique_ptr<ast::IfStmtNode> &node) {
-  llvm::Value *cond_expr = std::visit(*this, node->condition);
+void IRGen::emit_if(llvm::function_ref<llvm::Value *()> condition,
+                    llvm::function_ref<void()> then_stmt,
+                    llvm::function_ref<void()> else_stmt) {
+  llvm::Value *cond_expr = condition();
   llvm::Function *current_func = builder->GetInsertBlock()->getParent();
 
   llvm::BasicBlock *then_block =
@@ -286,13 +449,13 @@ void IRGen::operator()(std::unique_ptr<ast::IfStmtNode> &node) {
 
   builder->CreateCondBr(cond_expr, then_block, else_block);
   builder->SetInsertPoint(then_block);
-  std::visit(*this, node->then_stmt);
+  then_stmt();
   if (builder->GetInsertBlock()->getTerminator() == nullptr)
     builder->CreateBr(merge_block);
 
   current_func->insert(current_func->end(), else_block);
   builder->SetInsertPoint(else_block);
-  std::visit(*this, node->else_stmt);
+  else_stmt();
   if (builder->GetInsertBlock()->getTerminator() == nullptr)
     builder->CreateBr(merge_block);
 
@@ -300,7 +463,14 @@ void IRGen::operator()(std::unique_ptr<ast::IfStmtNode> &node) {
   builder->SetInsertPoint(merge_block);
 }
 
-void IRGen::operator()(std::unique_ptr<ast::WhileStmtNode> &node) {
+void IRGen::operator()(std::unique_ptr<ast::IfStmtNode> &node) {
+  emit_if([&] { return std::visit(*this, node->condition); },
+          [&] { std::visit(*this, node->then_stmt); },
+          [&] { std::visit(*this, node->else_stmt); });
+}
+
+void IRGen::emit_while(llvm::function_ref<llvm::Value *()> condition,
+                       llvm::function_ref<void()> body) {
   llvm::Function *current_func = builder->GetInsertBlock()->getParent();
 
   llvm::BasicBlock *cond_block =
@@ -312,7 +482,7 @@ void IRGen::operator()(std::unique_ptr<ast::WhileStmtNode> &node) {
 
   builder->CreateBr(cond_block);
   builder->SetInsertPoint(cond_block);
-  llvm::Value *cond_expr = std::visit(*this, node->condition);
+  llvm::Value *cond_expr = condition();
   builder->CreateCondBr(cond_expr, body_block, merge_block);
 
   current_func->insert(current_func->end(), body_block);
@@ -321,7 +491,7 @@ void IRGen::operator()(std::unique_ptr<ast::WhileStmtNode> &node) {
   current_loop_cond = cond_block;
   current_loop_merge = merge_block;
 
-  std::visit(*this, node->body);
+  body();
   if (builder->GetInsertBlock()->getTerminator() == nullptr)
     builder->CreateBr(cond_block);
 
@@ -332,6 +502,11 @@ void IRGen::operator()(std::unique_ptr<ast::WhileStmtNode> &node) {
   current_loop_merge = merge_block_old;
 }
 
+void IRGen::operator()(std::unique_ptr<ast::WhileStmtNode> &node) {
+  emit_while([&] { return std::visit(*this, node->condition); },
+             [&] { std::visit(*this, node->body); });
+}
+
 void IRGen::operator()(ast::BreakStmtNode &node) {
   if (current_loop_merge == nullptr)
     throw std::logic_error("break statement outside of loop");
@@ -350,46 +525,228 @@ void IRGen::operator()(ast::ReturnStmtNode &node) {
 }
 
 void IRGen::operator()(std::unique_ptr<ast::CompoundStmtNode> &node) {
+  variables.push_scope();
   for (auto &stmt : node->stmts)
     std::visit(*this, stmt);
+  variables.pop_scope();
 }
 
-void IRGen::operator()(ast::FunctionDeclNode &node) {
+llvm::Function *IRGen::declare_function(const ast::PrototypeNode &proto) {
   std::vector<llvm::Type *> arg_types;
-  for (auto &arg : node.proto.args) {
-    const std::string &type_name = arg.second;
-    llvm::Type *type = type_from_typename(type_name);
+  for (auto &arg : proto.args) {
+    llvm::Type *type = get_llvm_type(arg.second);
     if (type->isVoidTy())
       throw std::logic_error("void not allowed here");
     arg_types.push_back(type);
   }
-  llvm::Type *return_type = type_from_typename(node.proto.return_type);
+  llvm::Type *return_type = get_llvm_type(proto.return_type);
   llvm::FunctionType *func_type =
       llvm::FunctionType::get(return_type, arg_types, false);
-  llvm::Function *func =
-      llvm::Function::Create(func_type, llvm::Function::ExternalLinkage,
-                             node.proto.name, module.get());
-  auto arg_name_it = node.proto.args.begin();
+  llvm::Function *func = module->getFunction(proto.name.str());
+  if (func != nullptr && func->empty() && func->getFunctionType() == func_type)
+    return func;
+
+  func = llvm::Function::Create(func_type, llvm::Function::ExternalLinkage,
+                                proto.name.str(), module.get());
+  auto arg_name_it = proto.args.begin();
   for (auto &arg : func->args()) {
-    arg.setName(arg_name_it->first);
+    arg.setName(arg_name_it->first.str());
     arg_name_it++;
   }
-  if (!node.func_body.has_value())
+  if (effect_facts != nullptr)
+    if (const auto *effects = effect_facts->find(proto.name))
+      set_function_attributes(func, *effects);
+  return func;
+}
+
+void IRGen::set_function_attributes(llvm::Function *func,
+                                    const analysis::FunctionEffects &effects) {
+  // A division check traps through llvm.trap, which writes inaccessible
+  // memory.
+  if (effects.purity == analysis::Purity::Pure && effects.may_trap)
+    func->setOnlyAccessesInaccessibleMemory();
+  else if (effects.purity == analysis::Purity::Pure)
+    func->setDoesNotAccessMemory();
+  else if (effects.purity == analysis::Purity::ReadOnly)
+    func->setOnlyReadsMemory();
+  if (effects.no_unwind)
+    func->setDoesNotThrow();
+  if (effects.no_recurse)
+    func->setDoesNotRecurse();
+  if (effects.will_return)
+    func->setWillReturn();
+}
+
+void IRGen::set_effect_facts(const analysis::EffectFacts &facts) {
+  effect_facts = &facts;
+}
+
+void IRGen::emit_function(const ast::PrototypeNode &proto,
+                          llvm::function_ref<void()> body) {
+  llvm::Function *func = declare_function(proto);
+  if (!body)
     return;
 
   llvm::BasicBlock *func_block =
       llvm::BasicBlock::Create(*context, "entry", func);
   builder->SetInsertPoint(func_block);
-  current_scope_symbols.clear();
+  variables.clear();
+  auto arg_name_it = proto.args.begin();
   for (auto &arg : func->args()) {
     llvm::AllocaInst *alloc =
         create_entry_block_alloc(func, arg.getName(), arg.getType());
     builder->CreateStore(&arg, alloc);
-    current_scope_symbols[std::string(arg.getName())] = alloc;
+    variables.define(arg_name_it->first, alloc);
+    arg_name_it++;
+  }
+  body();
+  if (builder->GetInsertBlock()->getTerminator() == nullptr) {
+    if (func->getReturnType()->isVoidTy())
+      builder->CreateRetVoid();
+    else
+      builder->CreateRet(llvm::UndefValue::get(func->getReturnType()));
   }
-  std::visit(*this, node.func_body.value());
-  if (builder->GetInsertBlock()->getTerminator() == nullptr)
-    builder->CreateRet(llvm::UndefValue::get(return_type));
   llvm::verifyFunction(*func);
 }
+
+void IRGen::operator()(ast::FunctionDeclNode &node) {
+  if (!node.func_body.has_value()) {
+    emit_function(node.proto, nullptr);
+    return;
+  }
+  emit_function(node.proto,
+                [&] { std::visit(*this, node.func_body.value()); });
+}
+
+llvm::Value *IRGen::codegen_flat_expr(const ast::FlatExprPool &exprs,
+                                      ast::IndexRange range) {
+  // Nodes are in post-order, so the operands of a node are the values on top
+  // of the stack when it is reached.
+  std::vector<llvm::Value *> values;
+  for (auto i = range.begin; i < range.end; i++) {
+    std::uint32_t payload = exprs.payloads[i];
+    switch (exprs.kinds[i]) {
+    case ast::FlatExprKind::Int:
+      values.push_back(llvm::ConstantInt::get(
+          *context, llvm::APInt(32, payload, true)));
+      break;
+    case ast::FlatExprKind::Float:
+      values.push_back(llvm::ConstantFP::get(
+          *context, llvm::APFloat(exprs.floats[payload])));
+      break;
+    case ast::FlatExprKind::Bool:
+      values.push_back(llvm::ConstantInt::getBool(*context, payload != 0));
+      break;
+    case ast::FlatExprKind::Variable: {
+      llvm::AllocaInst *alloc = get_variable(util::Symbol::from_id(payload));
+      auto load = builder->CreateLoad(alloc->getAllocatedType(), alloc);
+      if (range_facts != nullptr)
+        set_range_metadata(load, range_facts->flat_range(i));
+      values.push_back(load);
+      break;
+    }
+    case ast::FlatExprKind::Unary: {
+      auto op = static_cast<ast::Op>(payload);
+      values.back() = unary_op(op, values.back());
+      if (range_facts != nullptr && op == ast::Op::Sub)
+        set_wrap_flags(values.back(),
+                       analysis::wrap_flags(ast::Op::Sub, {0, 0},
+                                            range_facts->flat_range(i - 1)));
+      break;
+    }
+    case ast::FlatExprKind::Binary: {
+      auto op = static_cast<ast::Op>(payload);
+      llvm::Value *rhs_val = values.back();
+      values.pop_back();
+      if (range_facts == nullptr) {
+        values.back() = binary_op(op, values.back(), rhs_val);
+        break;
+      }
+      auto lhs = exprs.subtree_begins[i - 1] - 1;
+      values.back() =
+          binary_op(op, values.back(), rhs_val, range_facts->flat_range(lhs),
+                    range_facts->flat_range(i - 1));
+      break;
+    }
+    case ast::FlatExprKind::Call: {
+      auto arg_count = exprs.arities[i];
+      auto callee_func = get_callee(util::Symbol::from_id(payload), arg_count);
+      std::vector<llvm::Value *> arg_vals(values.end() - arg_count,
+                                          values.end());
+      values.resize(values.size() - arg_count);
+      values.push_back(builder->CreateCall(callee_func, arg_vals));
+      break;
+    }
+    }
+  }
+  return values.back();
+}
+
+void IRGen::codegen_flat_stmt(const ast::FlatModule &module_node,
+                              ast::FlatStmtRef stmt) {
+  const auto &exprs = module_node.exprs;
+  switch (stmt.kind) {
+  case ast::FlatStmtKind::Let: {
+    const auto &let = module_node.lets[stmt.index];
+    emit_let(let.var_name, let.var_type);
+    break;
+  }
+  case ast::FlatStmtKind::Assignment: {
+    const auto &assignment = module_node.assignments[stmt.index];
+    llvm::Value *rhs_val = codegen_flat_expr(exprs, assignment.assign_expr),
+                *lhs_val = get_variable(assignment.var_name);
+    builder->CreateStore(rhs_val, lhs_val);
+    break;
+  }
+  case ast::FlatStmtKind::If: {
+    const auto &if_stmt = module_node.ifs[stmt.index];
+    emit_if([&] { return codegen_flat_expr(exprs, if_stmt.condition); },
+            [&] { codegen_flat_stmt(module_node, if_stmt.then_stmt); },
+            [&] { codegen_flat_stmt(module_node, if_stmt.else_stmt); });
+    break;
+  }
+  case ast::FlatStmtKind::While: {
+    const auto &while_stmt = module_node.whiles[stmt.index];
+    emit_while([&] { return codegen_flat_expr(exprs, while_stmt.condition); },
+               [&] { codegen_flat_stmt(module_node, while_stmt.body); });
+    break;
+  }
+  case ast::FlatStmtKind::Break: {
+    ast::BreakStmtNode node;
+    (*this)(node);
+    break;
+  }
+  case ast::FlatStmtKind::Continue: {
+    ast::ContinueStmtNode node;
+    (*this)(node);
+    break;
+  }
+  case ast::FlatStmtKind::Return:
+    builder->CreateRet(
+        codegen_flat_expr(exprs, module_node.returns[stmt.index].return_expr));
+    break;
+  case ast::FlatStmtKind::Compound: {
+    auto range = module_node.compounds[stmt.index].stmts;
+    variables.push_scope();
+    for (auto i = range.begin; i < range.end; i++)
+      codegen_flat_stmt(module_node, module_node.stmt_lists[i]);
+    variables.pop_scope();
+    break;
+  }
+  }
+}
+
+void IRGen::codegen(const ast::FlatModule &module_node) {
+  module->setModuleIdentifier(module_node.name);
+  for (const auto &func : module_node.functions)
+    declare_function(func.proto);
+  for (const auto &func : module_node.functions) {
+    if (!func.func_body.has_value()) {
+      emit_function(func.proto, nullptr);
+      continue;
+    }
+    emit_function(func.proto,
+                  [&] { codegen_flat_stmt(module_node, *func.func_body); });
+  }
+}
 } // namespace stapl::ir
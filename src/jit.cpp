@@ -0,0 +1,313 @@
+#include "jit.h"
+#include "object_cache.h"
+#include "optimizer.h"
+#include "target.h"
+#include "types.h"
+
+#include <bit>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include <llvm/Config/llvm-config.h>
+#include <llvm/ExecutionEngine/Orc/CompileUtils.h>
+#include <llvm/ExecutionEngine/Orc/Core.h>
+#include <llvm/ExecutionEngine/Orc/ExecutionUtils.h>
+#include <llvm/ExecutionEngine/Orc/IRCompileLayer.h>
+#include <llvm/ExecutionEngine/Orc/JITTargetMachineBuilder.h>
+#include <llvm/ExecutionEngine/Orc/LLJIT.h>
+#include <llvm/ExecutionEngine/Orc/ThreadSafeModule.h>
+#include <llvm/IR/BasicBlock.h>
+#include <llvm/IR/DerivedTypes.h>
+#include <llvm/IR/Function.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/Instructions.h>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+#include <llvm/IR/Type.h>
+#include <llvm/IR/Value.h>
+#include <llvm/Support/Casting.h>
+#include <llvm/Support/Error.h>
+#include <llvm/Support/TargetSelect.h>
+
+#include <fmt/core.h>
+
+namespace stapl::jit {
+namespace {
+/**
+ * @brief Name of the function added by ``JIT::add_trampoline``.
+ */
+constexpr std::string_view trampoline_name = "__stapl_run";
+
+/**
+ * @brief Signature of the function added by ``JIT::add_trampoline``.
+ */
+using Trampoline = std::int64_t (*)(const std::int64_t *);
+
+template <typename T> T unwrap(llvm::Expected<T> value) {
+  if (!value)
+    throw std::logic_error(llvm::toString(value.takeError()));
+  return std::move(*value);
+}
+
+void check(llvm::Error err) {
+  if (err)
+    throw std::logic_error(llvm::toString(std::move(err)));
+}
+
+std::string cache_tag(llvm::orc::JITTargetMachineBuilder &machine_builder,
+                      opt::OptLevel level) {
+  return fmt::format("LLVM {} {} {} {} O{}", LLVM_VERSION_STRING,
+                     machine_builder.getTargetTriple().str(),
+                     machine_builder.getCPU(),
+                     machine_builder.getFeatures().getString(),
+                     static_cast<int>(level));
+}
+
+types::TypeId to_stapl_type(llvm::Type *type) {
+  if (type->isIntegerTy(32))
+    return types::int_type;
+  if (type->isDoubleTy())
+    return types::float_type;
+  if (type->isIntegerTy(1))
+    return types::bool_type;
+  if (type->isVoidTy())
+    return types::void_type;
+  throw std::logic_error("unsupported type in signature of entry function");
+}
+
+llvm::Value *from_slot(llvm::IRBuilder<> &builder, llvm::Value *slot,
+                       llvm::Type *type) {
+  if (type->isDoubleTy())
+    return builder.CreateBitCast(slot, type);
+  return builder.CreateTrunc(slot, type);
+}
+
+llvm::Value *to_slot(llvm::IRBuilder<> &builder, llvm::Value *value) {
+  auto *slot_type = builder.getInt64Ty();
+  auto *type = value->getType();
+  if (type->isVoidTy())
+    return builder.getInt64(0);
+  if (type->isDoubleTy())
+    return builder.CreateBitCast(value, slot_type);
+  if (type->isIntegerTy(1))
+    return builder.CreateZExt(value, slot_type);
+  return builder.CreateSExt(value, slot_type);
+}
+
+std::int64_t parse_arg(const std::string &arg, types::TypeId type) {
+  const auto *first = arg.data();
+  const auto *last = arg.data() + arg.size();
+  if (type == types::int_type) {
+    std::int32_t value;
+    auto [ptr, ec] = std::from_chars(first, last, value);
+    if (ec == std::errc() && ptr == last)
+      return value;
+  } else if (type == types::float_type) {
+    double value;
+    auto [ptr, ec] = std::from_chars(first, last, value);
+    if (ec == std::errc() && ptr == last)
+      return std::bit_cast<std::int64_t>(value);
+  } else if (arg == "true")
+    return 1;
+  else if (arg == "false")
+    return 0;
+  throw std::logic_error(
+      fmt::format("invalid {} argument: {}", type.str(), arg));
+}
+
+std::optional<std::string> format_result(std::int64_t result,
+                                         types::TypeId type) {
+  if (type == types::int_type)
+    return fmt::format("{}", static_cast<std::int32_t>(result));
+  if (type == types::float_type)
+    return fmt::format("{}", std::bit_cast<double>(result));
+  if (type == types::bool_type)
+    return result != 0 ? "true" : "false";
+  return std::nullopt;
+}
+} // namespace
+
+JIT::JIT(const JITOptions &options) : options(options) {
+  if (this->options.speculate && this->options.compile_threads == 0)
+    this->options.compile_threads = 1;
+  llvm::InitializeNativeTarget();
+  llvm::InitializeNativeTargetAsmPrinter();
+  auto machine_builder =
+      unwrap(llvm::orc::JITTargetMachineBuilder::detectHost());
+  machine_builder.setCodeGenOptLevel(
+      target::codegen_opt_level(options.opt_level));
+  machine = unwrap(machine_builder.createTargetMachine());
+  if (!options.cache_dir.empty())
+    cache = std::make_unique<ObjectCache>(
+        options.cache_dir, options.cache_size,
+        cache_tag(machine_builder, options.opt_level));
+
+  auto configure = [this, &machine_builder](auto &builder) {
+    builder.setJITTargetMachineBuilder(machine_builder)
+        .setNumCompileThreads(this->options.compile_threads);
+    if (cache)
+      builder.setCompileFunctionCreator(
+          [this](llvm::orc::JITTargetMachineBuilder machine_builder)
+              -> llvm::Expected<
+                  std::unique_ptr<llvm::orc::IRCompileLayer::IRCompiler>> {
+            if (this->options.compile_threads > 0)
+              return std::make_unique<llvm::orc::ConcurrentIRCompiler>(
+                  std::move(machine_builder), cache.get());
+            auto compile_machine = machine_builder.createTargetMachine();
+            if (!compile_machine)
+              return compile_machine.takeError();
+            return std::make_unique<llvm::orc::TMOwningSimpleCompiler>(
+                std::move(*compile_machine), cache.get());
+          });
+  };
+  if (options.lazy) {
+    llvm::orc::LLLazyJITBuilder builder;
+    configure(builder);
+    auto lazy = unwrap(builder.create());
+    lazy_jit = lazy.get();
+    jit = std::move(lazy);
+  } else {
+    llvm::orc::LLJITBuilder builder;
+    configure(builder);
+    jit = unwrap(builder.create());
+  }
+
+  auto process_symbols =
+      unwrap(llvm::orc::DynamicLibrarySearchGenerator::GetForCurrentProcess(
+          jit->getDataLayout().getGlobalPrefix()));
+  jit->getMainJITDylib().addGenerator(std::move(process_symbols));
+  jit->getIRTransformLayer().setTransform(
+      [this, machine_builder](llvm::orc::ThreadSafeModule module,
+                              llvm::orc::MaterializationResponsibility &)
+          -> llvm::Expected<llvm::orc::ThreadSafeModule> {
+        // A target machine is not thread safe, so each module compiled on a
+        // compile thread gets its own.
+        std::unique_ptr<llvm::TargetMachine> thread_machine;
+        if (this->options.compile_threads > 0) {
+          auto thread_builder = machine_builder;
+          auto created = thread_builder.createTargetMachine();
+          if (!created)
+            return created.takeError();
+          thread_machine = std::move(*created);
+        }
+        auto *target = thread_machine ? thread_machine.get() : machine.get();
+        module.withModuleDo([this, target](llvm::Module &module) {
+          opt::optimize_module(module, this->options.opt_level, target);
+        });
+        return std::move(module);
+      });
+}
+
+void JIT::find_callees(const llvm::Function &entry) {
+  entry_callees.clear();
+  std::vector<const llvm::Function *> worklist = {&entry};
+  std::unordered_set<const llvm::Function *> visited = {&entry};
+  for (std::size_t i = 0; i < worklist.size(); i++)
+    for (const auto &block : *worklist[i])
+      for (const auto &inst : block) {
+        const auto *call = llvm::dyn_cast<llvm::CallInst>(&inst);
+        if (call == nullptr)
+          continue;
+        const auto *callee = call->getCalledFunction();
+        if (callee == nullptr || callee->isDeclaration() ||
+            !visited.insert(callee).second)
+          continue;
+        worklist.push_back(callee);
+        entry_callees.push_back(callee->getName().str());
+      }
+}
+
+void JIT::speculate_callees() {
+  // Lazy reexports in the main library point to the implementations in the
+  // library the compile-on-demand layer creates, where looking a symbol up
+  // compiles it.
+  auto &session = jit->getExecutionSession();
+  auto *impl_dylib =
+      session.getJITDylibByName(jit->getMainJITDylib().getName() + ".impl");
+  if (impl_dylib == nullptr || entry_callees.empty())
+    return;
+  llvm::orc::SymbolLookupSet symbols;
+  for (const auto &callee : entry_callees)
+    symbols.add(jit->mangleAndIntern(callee));
+  session.lookup(
+      llvm::orc::LookupKind::Static,
+      llvm::orc::makeJITDylibSearchOrder(impl_dylib), std::move(symbols),
+      llvm::orc::SymbolState::Ready,
+      [](llvm::Expected<llvm::orc::SymbolMap> result) {
+        // A function which fails to compile is reported when it is called.
+        llvm::consumeError(result.takeError());
+      },
+      llvm::orc::NoDependenciesToRegister);
+}
+
+void JIT::add_trampoline(llvm::Module &module) {
+  auto *entry = module.getFunction(options.entry);
+  if (entry == nullptr || entry->isDeclaration())
+    throw std::logic_error(
+        fmt::format("unknown entry function: {}", options.entry));
+
+  llvm::IRBuilder<> builder(module.getContext());
+  auto *slot_type = builder.getInt64Ty();
+  auto *trampoline_type = llvm::FunctionType::get(
+      slot_type, {llvm::PointerType::getUnqual(slot_type)}, false);
+  auto *trampoline =
+      llvm::Function::Create(trampoline_type, llvm::Function::ExternalLinkage,
+                             trampoline_name, module);
+  builder.SetInsertPoint(
+      llvm::BasicBlock::Create(module.getContext(), "entry", trampoline));
+
+  entry_params.clear();
+  std::vector<llvm::Value *> args;
+  for (auto &param : entry->args()) {
+    entry_params.push_back(to_stapl_type(param.getType()));
+    auto *slot_ptr = builder.CreateConstInBoundsGEP1_64(
+        slot_type, trampoline->getArg(0), param.getArgNo());
+    auto *slot = builder.CreateLoad(slot_type, slot_ptr);
+    args.push_back(from_slot(builder, slot, param.getType()));
+  }
+  entry_return = to_stapl_type(entry->getReturnType());
+  find_callees(*entry);
+  builder.CreateRet(to_slot(builder, builder.CreateCall(entry, args)));
+}
+
+void JIT::add_module(std::unique_ptr<llvm::LLVMContext> context,
+                     std::unique_ptr<llvm::Module> module) {
+  llvm::orc::ThreadSafeModule safe_module(std::move(module),
+                                          std::move(context));
+  safe_module.withModuleDo([this](llvm::Module &module) {
+    module.setDataLayout(jit->getDataLayout());
+    module.setTargetTriple(jit->getTargetTriple().str());
+    add_trampoline(module);
+  });
+  if (lazy_jit != nullptr)
+    check(lazy_jit->addLazyIRModule(std::move(safe_module)));
+  else
+    check(jit->addIRModule(std::move(safe_module)));
+}
+
+std::optional<std::string> JIT::run(const std::vector<std::string> &args) {
+  if (args.size() != entry_params.size())
+    throw std::logic_error(
+        fmt::format("arg count mismatch: expected {} args, got {} args",
+                    entry_params.size(), args.size()));
+  std::vector<std::int64_t> slots;
+  for (std::size_t i = 0; i < args.size(); i++)
+    slots.push_back(parse_arg(args[i], entry_params[i]));
+
+  auto symbol = unwrap(jit->lookup(trampoline_name));
+  if (lazy_jit != nullptr && options.speculate)
+    speculate_callees();
+  auto trampoline = symbol.toPtr<Trampoline>();
+  return format_result(trampoline(slots.data()), entry_return);
+}
+} // namespace stapl::jit
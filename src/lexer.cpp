@@ -1,77 +1,326 @@
 #include "lexer.h"
+#include "ops.h"
+#include "scan.h"
 
+#include <algorithm>
+#include <array>
 #include <cctype>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <istream>
+#include <stdexcept>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#include <fmt/core.h>
 
 namespace stapl::parsing {
-Lexer::Lexer(std::string code)
-    : code(code), last_char(' '), operator_dfa({{'<', {'\0', '='}},
-                                                {'>', {'\0', '='}},
-                                                {'=', {'\0', '='}},
-                                                {'!', {'\0', '='}},
-                                                {'+', {'\0'}},
-                                                {'-', {'\0'}},
-                                                {'*', {'\0'}},
-                                                {'/', {'\0'}},
-                                                {'%', {'\0'}}}),
-      token_table({{"def", TokenKind::Def},
-                   {"extern", TokenKind::Extern},
-                   {"if", TokenKind::If},
-                   {"else", TokenKind::Else},
-                   {"while", TokenKind::While},
-                   {"break", TokenKind::Break},
-                   {"continue", TokenKind::Continue},
-                   {"let", TokenKind::Let},
-                   {"return", TokenKind::Return},
-                   {"true", TokenKind::Bool},
-                   {"false", TokenKind::Bool},
-                   {"module", TokenKind::Module}}) {
-  it = this->code.begin();
+namespace {
+struct Keyword {
+  std::string_view text;
+  TokenKind kind = TokenKind::Identifier;
+};
+
+constexpr std::array<Keyword, 12> keywords = {
+    {{"def", TokenKind::Def},
+     {"extern", TokenKind::Extern},
+     {"if", TokenKind::If},
+     {"else", TokenKind::Else},
+     {"while", TokenKind::While},
+     {"break", TokenKind::Break},
+     {"continue", TokenKind::Continue},
+     {"let", TokenKind::Let},
+     {"return", TokenKind::Return},
+     {"true", TokenKind::Bool},
+     {"false", TokenKind::Bool},
+     {"module", TokenKind::Module}}};
+
+constexpr std::size_t keyword_table_size = 32;
+
+// Length and first character are enough to tell all keywords apart; the
+// static_assert below fails if a new keyword breaks that.
+constexpr std::size_t keyword_hash(std::string_view word) {
+  return (word.size() + static_cast<unsigned char>(word.front()) * 3) %
+         keyword_table_size;
+}
+
+constexpr auto keyword_table = [] {
+  std::array<Keyword, keyword_table_size> table{};
+  for (const auto &keyword : keywords)
+    table[keyword_hash(keyword.text)] = keyword;
+  return table;
+}();
+
+constexpr bool keyword_hash_is_perfect() {
+  for (const auto &keyword : keywords)
+    if (keyword_table[keyword_hash(keyword.text)].text != keyword.text)
+      return false;
+  return true;
+}
+static_assert(keyword_hash_is_perfect(), "keyword hash has collisions");
+
+// Character classes and states of the operator DFA. Every operator is either
+// a single arithmetic character, or a comparison prefix optionally followed by
+// '='.
+enum OpClass : std::uint8_t { NotOp, Arith, CmpPrefix, Equal, NumOpClasses };
+
+enum OpState : std::uint8_t {
+  Start,
+  AfterArith,
+  AfterCmpPrefix,
+  Done,
+  Reject,
+  NumOpStates = Reject
+};
+
+constexpr auto op_class = [] {
+  std::array<OpClass, 256> table{};
+  for (unsigned char c : std::string_view("+-*/%"))
+    table[c] = Arith;
+  for (unsigned char c : std::string_view("<>!"))
+    table[c] = CmpPrefix;
+  table['='] = Equal;
+  return table;
+}();
+
+constexpr auto op_transition = [] {
+  std::array<std::array<OpState, NumOpClasses>, NumOpStates> table{};
+  for (auto &row : table)
+    row.fill(Reject);
+  table[Start][Arith] = AfterArith;
+  table[Start][CmpPrefix] = AfterCmpPrefix;
+  table[Start][Equal] = AfterCmpPrefix;
+  table[AfterCmpPrefix][Equal] = Done;
+  return table;
+}();
+
+TokenKind keyword_or_identifier(std::string_view word) {
+  const auto &entry = keyword_table[keyword_hash(word)];
+  if (entry.text == word)
+    return entry.kind;
+  return TokenKind::Identifier;
+}
+
+template <typename T> T convert_number(std::string_view num_str) {
+  T value;
+  auto [end, ec] =
+      std::from_chars(num_str.data(), num_str.data() + num_str.size(), value);
+  if (ec == std::errc::result_out_of_range)
+    throw std::logic_error(
+        fmt::format("number literal out of range: {}", num_str));
+  if (ec != std::errc() || end != num_str.data() + num_str.size())
+    throw std::logic_error(
+        fmt::format("malformed number literal: {}", num_str));
+  return value;
+}
+
+bool starts_with_word(std::string_view code, std::size_t pos,
+                      std::string_view word) {
+  return code.substr(pos, word.size()) == word &&
+         scan::skip_identifier(code, pos + word.size(), scan::Isa::Scalar) ==
+             pos + word.size();
+}
+
+// Positions of lines starting with a top-level keyword, picked so that the
+// chunks between them are of similar size.
+std::vector<std::size_t> find_split_points(std::string_view code,
+                                           unsigned jobs) {
+  std::vector<std::size_t> splits = {0};
+  std::size_t target = code.size() / jobs;
+  for (std::size_t pos = code.find('\n', target); pos != std::string_view::npos;
+       pos = code.find('\n', pos + 1)) {
+    std::size_t line = pos + 1;
+    if (line - splits.back() < target)
+      continue;
+    if (!starts_with_word(code, line, "def") &&
+        !starts_with_word(code, line, "extern"))
+      continue;
+    splits.push_back(line);
+    if (splits.size() == jobs)
+      break;
+  }
+  splits.push_back(code.size());
+  return splits;
+}
+
+void lex_chunk(std::string_view code, std::vector<Token> &tokens) {
+  Lexer lexer(code);
+  for (auto token = lexer.get_token(); token.kind != TokenKind::Eof;
+       token = lexer.get_token())
+    tokens.push_back(token);
+}
+} // namespace
+
+Token::Token(TokenKind kind, std::string_view text, TokenValue value)
+    : kind(kind), text(text), value(value) {}
+
+Lexer::Lexer(std::string_view code)
+    : code(code), pos(0), token_start(0), input(nullptr), chunk_size(0) {}
+
+Lexer::Lexer(std::istream &input, std::size_t chunk_size)
+    : pos(0), token_start(0), input(&input),
+      chunk_size(chunk_size == 0 ? 1 : chunk_size) {}
+
+bool Lexer::refill() {
+  if (input == nullptr || !input->good())
+    return false;
+  buffer.erase(0, token_start);
+  pos -= token_start;
+  token_start = 0;
+  std::size_t kept = buffer.size();
+  buffer.resize(kept + chunk_size);
+  input->read(buffer.data() + kept, static_cast<std::streamsize>(chunk_size));
+  buffer.resize(kept + static_cast<std::size_t>(input->gcount()));
+  code = buffer;
+  return buffer.size() > kept;
+}
+
+void Lexer::advance(std::size_t (*scan_fn)(std::string_view, std::size_t,
+                                           scan::Isa),
+                    bool keep) {
+  while ((pos = scan_fn(code, pos, scan::detected_isa())) == code.size()) {
+    if (!keep)
+      token_start = pos;
+    if (!refill())
+      break;
+  }
+}
+
+int Lexer::peek() {
+  if (pos >= code.size() && !refill())
+    return '\0';
+  return static_cast<unsigned char>(code[pos]);
 }
 
 Token Lexer::get_token() {
-  while (std::isspace(last_char))
-    last_char = *(it++);
-  if (std::isalpha(last_char)) {
-    identifier = last_char;
-    while (std::isalnum(last_char = *(it++)) || last_char == '_')
-      identifier += last_char;
-    auto kind = TokenKind::Identifier;
-    if (token_table.contains(identifier))
-      kind = token_table[identifier];
-    return {kind, identifier};
+  token_start = pos;
+  advance(scan::skip_whitespace, false);
+  token_start = pos;
+  int this_char = peek();
+  if (std::isalpha(this_char)) {
+    pos++;
+    advance(scan::skip_identifier, true);
+    auto identifier = code.substr(token_start, pos - token_start);
+    return {keyword_or_identifier(identifier), identifier};
   }
 
-  if (std::isdigit(last_char) || last_char == '.') {
-    std::string num_str;
-    do {
-      num_str += last_char;
-      last_char = *(it++);
-    } while (std::isdigit(last_char) || last_char == '.');
-    if (num_str.find('.') != std::string::npos)
-      return {TokenKind::Float, num_str};
-    return {TokenKind::Int, num_str};
+  if (std::isdigit(this_char) || this_char == '.') {
+    pos++;
+    advance(scan::skip_number, true);
+    auto num_str = code.substr(token_start, pos - token_start);
+    if (num_str.find('.') != std::string_view::npos)
+      return {TokenKind::Float, num_str, convert_number<double>(num_str)};
+    return {TokenKind::Int, num_str, convert_number<std::int64_t>(num_str)};
   }
 
-  if (last_char == '#') {
-    do
-      last_char = *(it++);
-    while (last_char != '\0' && last_char != '\n' && last_char != '\r');
-    if (last_char != '\0')
+  if (this_char == '#') {
+    pos++;
+    advance(scan::find_line_end, false);
+    if (peek() != '\0')
       return get_token();
   }
 
-  if (last_char == '\0')
-    return {TokenKind::Eof, ""};
-
-  int this_char = last_char;
-  last_char = *(it++);
-  if (!operator_dfa.count(this_char))
-    return {TokenKind::Misc, std::string(1, this_char)};
-  op = this_char;
-  while (operator_dfa[op.back()].contains(last_char)) {
-    op += last_char;
-    last_char = *(it++);
+  if (peek() == '\0')
+    return {TokenKind::Eof, code.substr(pos, 0)};
+
+  pos++;
+  OpState state = op_transition[Start][op_class[this_char]];
+  if (state == Reject)
+    return {TokenKind::Misc, code.substr(token_start, 1)};
+  while ((state = op_transition[state][op_class[peek()]]) != Reject)
+    pos++;
+  auto op_str = code.substr(token_start, pos - token_start);
+  if (auto op = ast::op_from_text(op_str))
+    return {TokenKind::Op, op_str, *op};
+  return {TokenKind::Op, op_str};
+}
+
+std::vector<Token> tokenize(std::string_view code) {
+  std::vector<Token> tokens;
+  lex_chunk(code, tokens);
+  tokens.push_back(
+      {TokenKind::Eof, code.substr(std::min(code.find('\0'), code.size()), 0)});
+  return tokens;
+}
+
+std::vector<Token> tokenize_parallel(std::string_view code, unsigned jobs) {
+  code = code.substr(0, code.find('\0'));
+  if (jobs <= 1)
+    return tokenize(code);
+
+  auto splits = find_split_points(code, jobs);
+  std::vector<std::vector<Token>> chunk_tokens(splits.size() - 1);
+  std::vector<std::future<void>> futures;
+  for (std::size_t i = 0; i + 1 < splits.size(); i++)
+    futures.push_back(std::async(
+        std::launch::async, lex_chunk,
+        code.substr(splits[i], splits[i + 1] - splits[i]),
+        std::ref(chunk_tokens[i])));
+  for (auto &future : futures)
+    future.wait();
+
+  std::vector<Token> tokens;
+  for (std::size_t i = 0; i < futures.size(); i++) {
+    futures[i].get();
+    tokens.insert(tokens.end(), chunk_tokens[i].begin(), chunk_tokens[i].end());
+  }
+  tokens.push_back({TokenKind::Eof, code.substr(code.size(), 0)});
+  return tokens;
+}
+
+TokenRange relex(std::vector<Token> &tokens, std::string_view old_code,
+                 std::string_view new_code, const TextEdit &edit) {
+  if (edit.offset > old_code.size() ||
+      edit.length > old_code.size() - edit.offset ||
+      new_code.size() !=
+          old_code.size() - edit.length + edit.replacement.size())
+    throw std::logic_error("edit does not fit the code");
+
+  auto old_offset = [&](std::size_t i) -> std::size_t {
+    return tokens[i].text.data() - old_code.data();
+  };
+  std::size_t restart =
+      edit.offset == 0 ? 0 : old_code.rfind('\n', edit.offset - 1) + 1;
+  std::size_t first = 0;
+  while (first < tokens.size() && old_offset(first) < restart)
+    first++;
+
+  // Tokens after the edit are at the same offset shifted by `delta`, so lexing
+  // can stop at the first new token starting where an old token started.
+  std::size_t new_edit_end = edit.offset + edit.replacement.size();
+  auto delta = static_cast<std::ptrdiff_t>(edit.replacement.size()) -
+               static_cast<std::ptrdiff_t>(edit.length);
+  std::size_t resync = first;
+  std::vector<Token> relexed;
+  Lexer lexer(new_code.substr(restart));
+  while (true) {
+    auto token = lexer.get_token();
+    std::size_t offset = token.text.data() - new_code.data();
+    if (offset >= new_edit_end) {
+      auto shifted = static_cast<std::size_t>(offset - delta);
+      while (resync < tokens.size() && old_offset(resync) < shifted)
+        resync++;
+      if (resync < tokens.size() && old_offset(resync) == shifted)
+        break;
+    }
+    relexed.push_back(token);
+    if (token.kind == TokenKind::Eof) {
+      resync = tokens.size();
+      break;
+    }
   }
-  return {TokenKind::Op, op};
+
+  for (std::size_t i = 0; i < first; i++)
+    tokens[i].text = new_code.substr(old_offset(i), tokens[i].text.size());
+  for (std::size_t i = resync; i < tokens.size(); i++)
+    tokens[i].text =
+        new_code.substr(old_offset(i) + delta, tokens[i].text.size());
+  auto begin = tokens.erase(tokens.begin() + first, tokens.begin() + resync);
+  tokens.insert(begin, relexed.begin(), relexed.end());
+  return {first, first + relexed.size()};
 }
 } // namespace stapl::parsing
@@ -0,0 +1,137 @@
+#include "object_cache.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Bitcode/BitcodeWriter.h>
+#include <llvm/IR/Module.h>
+#include <llvm/Support/Error.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/SHA1.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <fmt/core.h>
+
+namespace fs = std::filesystem;
+
+namespace stapl::jit {
+ObjectCache::ObjectCache(fs::path directory, std::uintmax_t max_size,
+                         std::string tag)
+    : directory(std::move(directory)), max_size(max_size),
+      tag(std::move(tag)) {
+  std::error_code ec;
+  fs::create_directories(this->directory, ec);
+  if (ec)
+    throw std::logic_error(
+        fmt::format("cannot create cache directory {}: {}",
+                    this->directory.string(), ec.message()));
+  std::lock_guard lock(mutex);
+  evict();
+}
+
+std::string ObjectCache::key(const llvm::Module &module) const {
+  llvm::SmallVector<char, 0> bitcode;
+  llvm::raw_svector_ostream out(bitcode);
+  llvm::WriteBitcodeToFile(module, out);
+  llvm::SHA1 hasher;
+  hasher.update(llvm::StringRef(bitcode.data(), bitcode.size()));
+  hasher.update(tag);
+  return llvm::toHex(hasher.final(), true);
+}
+
+fs::path ObjectCache::object_path(const std::string &key) const {
+  return directory / (key + ".o");
+}
+
+void ObjectCache::evict() {
+  std::vector<std::pair<fs::file_time_type, fs::path>> objects;
+  std::uintmax_t size = 0;
+  std::error_code ec;
+  for (const auto &entry : fs::directory_iterator(directory, ec)) {
+    if (!entry.is_regular_file(ec) || entry.path().extension() != ".o")
+      continue;
+    size += entry.file_size(ec);
+    objects.emplace_back(entry.last_write_time(ec), entry.path());
+  }
+  std::sort(objects.begin(), objects.end());
+  for (const auto &[time, path] : objects) {
+    if (size <= max_size)
+      break;
+    auto object_size = fs::file_size(path, ec);
+    if (!ec && fs::remove(path, ec))
+      size -= object_size;
+  }
+  total_size = size;
+}
+
+void ObjectCache::notifyObjectCompiled(const llvm::Module *module,
+                                       llvm::MemoryBufferRef object) {
+  std::string module_key;
+  {
+    std::lock_guard lock(mutex);
+    auto it = pending_keys.find(module);
+    if (it == pending_keys.end())
+      return;
+    module_key = std::move(it->second);
+    pending_keys.erase(it);
+  }
+
+  // Write to a temporary file first, so that readers never see a partial
+  // object.
+  auto path = object_path(module_key).string();
+  auto temp = llvm::sys::fs::TempFile::create(path + ".%%%%%%.tmp");
+  if (!temp) {
+    llvm::consumeError(temp.takeError());
+    return;
+  }
+  bool failed;
+  {
+    llvm::raw_fd_ostream out(temp->FD, false);
+    out << object.getBuffer();
+    out.flush();
+    // A write error left unchecked makes the destructor of ``out`` abort, so
+    // a full disk is cleared like any other failure to write the cache.
+    failed = out.has_error();
+    out.clear_error();
+  }
+  if (failed) {
+    llvm::consumeError(temp->discard());
+    return;
+  }
+  if (auto err = temp->keep(path)) {
+    llvm::consumeError(std::move(err));
+    return;
+  }
+
+  std::lock_guard lock(mutex);
+  total_size += object.getBufferSize();
+  if (total_size > max_size)
+    evict();
+}
+
+std::unique_ptr<llvm::MemoryBuffer>
+ObjectCache::getObject(const llvm::Module *module) {
+  auto module_key = key(*module);
+  auto path = object_path(module_key);
+  if (auto object = llvm::MemoryBuffer::getFile(path.string())) {
+    std::error_code ec;
+    fs::last_write_time(path, fs::file_time_type::clock::now(), ec);
+    return std::move(*object);
+  }
+  std::lock_guard lock(mutex);
+  pending_keys[module] = std::move(module_key);
+  return nullptr;
+}
+} // namespace stapl::jit
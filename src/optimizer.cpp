@@ -0,0 +1,92 @@
+#include "optimizer.h"
+
+#include <optional>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+
+#include <llvm/Analysis/CGSCCPassManager.h>
+#include <llvm/Analysis/LoopAnalysisManager.h>
+#include <llvm/IR/Module.h>
+#include <llvm/IR/PassManager.h>
+#include <llvm/Passes/OptimizationLevel.h>
+#include <llvm/Passes/PassBuilder.h>
+#include <llvm/Support/Error.h>
+#include <llvm/Target/TargetMachine.h>
+
+#include <fmt/core.h>
+
+namespace stapl::opt {
+namespace {
+/**
+ * @brief Analysis managers of all IR units, registered with a pass builder
+ * and linked to each other.
+ */
+struct AnalysisManagers {
+  llvm::LoopAnalysisManager loop;
+  llvm::FunctionAnalysisManager function;
+  llvm::CGSCCAnalysisManager cgscc;
+  llvm::ModuleAnalysisManager module;
+
+  explicit AnalysisManagers(llvm::PassBuilder &pass_builder) {
+    pass_builder.registerModuleAnalyses(module);
+    pass_builder.registerCGSCCAnalyses(cgscc);
+    pass_builder.registerFunctionAnalyses(function);
+    pass_builder.registerLoopAnalyses(loop);
+    pass_builder.crossRegisterProxies(loop, function, cgscc, module);
+  }
+};
+
+llvm::OptimizationLevel to_llvm_level(OptLevel level) {
+  switch (level) {
+  case OptLevel::O0:
+    return llvm::OptimizationLevel::O0;
+  case OptLevel::O1:
+    return llvm::OptimizationLevel::O1;
+  case OptLevel::O2:
+    return llvm::OptimizationLevel::O2;
+  case OptLevel::O3:
+    return llvm::OptimizationLevel::O3;
+  default:
+    return llvm::OptimizationLevel::Os;
+  }
+}
+} // namespace
+
+std::optional<OptLevel> parse_opt_level(std::string_view text) {
+  if (text == "0")
+    return OptLevel::O0;
+  if (text == "1")
+    return OptLevel::O1;
+  if (text == "2")
+    return OptLevel::O2;
+  if (text == "3")
+    return OptLevel::O3;
+  if (text == "s")
+    return OptLevel::Os;
+  return std::nullopt;
+}
+
+void optimize_module(llvm::Module &module, OptLevel level,
+                     llvm::TargetMachine *machine) {
+  llvm::PassBuilder pass_builder(machine);
+  AnalysisManagers managers(pass_builder);
+  auto llvm_level = to_llvm_level(level);
+  auto pass_manager =
+      level == OptLevel::O0
+          ? pass_builder.buildO0DefaultPipeline(llvm_level)
+          : pass_builder.buildPerModuleDefaultPipeline(llvm_level);
+  pass_manager.run(module, managers.module);
+}
+
+void run_passes(llvm::Module &module, std::string_view pipeline,
+                llvm::TargetMachine *machine) {
+  llvm::PassBuilder pass_builder(machine);
+  AnalysisManagers managers(pass_builder);
+  llvm::ModulePassManager pass_manager;
+  if (auto err = pass_builder.parsePassPipeline(pass_manager, pipeline))
+    throw std::logic_error(
+        fmt::format("{}: {}", pipeline, llvm::toString(std::move(err))));
+  pass_manager.run(module, managers.module);
+}
+} // namespace stapl::opt
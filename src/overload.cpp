@@ -0,0 +1,87 @@
+#include "overload.h"
+#include "symbol.h"
+#include "types.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include <fmt/core.h>
+
+namespace stapl::types {
+std::size_t OverloadTable::hash_key(util::Symbol name,
+                                    std::span<const TypeId> arg_types) {
+  std::size_t hash = name.id();
+  for (auto arg_type : arg_types)
+    hash ^= arg_type.id() + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+  return hash;
+}
+
+std::size_t OverloadTable::find_slot(util::Symbol name,
+                                     std::span<const TypeId> arg_types,
+                                     std::size_t hash) const {
+  std::size_t mask = slots.size() - 1;
+  for (std::size_t i = hash & mask;; i = (i + 1) & mask) {
+    if (slots[i] == 0)
+      return i;
+    const auto &overload = overloads[slots[i] - 1];
+    if (overload.hash == hash && overload.name == name &&
+        std::equal(arg_types.begin(), arg_types.end(),
+                   arg_type_pool.begin() + overload.args_begin,
+                   arg_type_pool.begin() + overload.args_begin +
+                       overload.arity))
+      return i;
+  }
+}
+
+void OverloadTable::grow() {
+  slots.assign(std::max<std::size_t>(slots.size() * 2, 16), 0);
+  std::size_t mask = slots.size() - 1;
+  for (std::size_t index = 0; index < overloads.size(); index++) {
+    auto i = overloads[index].hash & mask;
+    while (slots[i] != 0)
+      i = (i + 1) & mask;
+    slots[i] = static_cast<std::uint32_t>(index + 1);
+  }
+}
+
+void OverloadTable::add(util::Symbol name, std::span<const TypeId> arg_types,
+                        TypeId return_type) {
+  // Keep the load factor at most 1/2, so that probe sequences stay short.
+  if ((overloads.size() + 1) * 2 > slots.size())
+    grow();
+  auto hash = hash_key(name, arg_types);
+  auto slot = find_slot(name, arg_types, hash);
+  if (slots[slot] != 0) {
+    if (overloads[slots[slot] - 1].return_type == return_type)
+      throw std::logic_error(
+          fmt::format("duplicate overload of {}", name.str()));
+    throw std::logic_error(fmt::format(
+        "ambiguous overload of {}: overloads differ only in return type",
+        name.str()));
+  }
+  overloads.push_back({name, static_cast<std::uint32_t>(arg_type_pool.size()),
+                       static_cast<std::uint32_t>(arg_types.size()),
+                       return_type, hash});
+  arg_type_pool.insert(arg_type_pool.end(), arg_types.begin(),
+                       arg_types.end());
+  slots[slot] = static_cast<std::uint32_t>(overloads.size());
+}
+
+std::optional<TypeId>
+OverloadTable::find(util::Symbol name,
+                    std::span<const TypeId> arg_types) const {
+  if (slots.empty())
+    return std::nullopt;
+  auto slot = find_slot(name, arg_types, hash_key(name, arg_types));
+  if (slots[slot] == 0)
+    return std::nullopt;
+  return overloads[slots[slot] - 1].return_type;
+}
+
+std::size_t OverloadTable::size() const { return overloads.size(); }
+} // namespace stapl::types
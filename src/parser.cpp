@@ -1,42 +1,98 @@
 #include "parser.h"
+#include "arena.h"
 #include "ast.h"
 #include "lexer.h"
-
+#include "ops.h"
+#include "symbol.h"
+#include "token_buffer.h"
+#include "types.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
 #include <iostream>
+#include <istream>
+#include <limits>
 #include <memory>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 #include <utility>
+#include <variant>
 #include <vector>
 
 #include <fmt/core.h>
 
 namespace stapl::parsing {
-Parser::Parser(std::string code) : lexer(code) { next_token(); }
+Parser::Parser(std::string_view code) : Parser(TokenBuffer(code)) {}
+
+Parser::Parser(std::istream &input) : lexer(input), streaming(true) {
+  next_token();
+}
+
+Parser::Parser(TokenBuffer tokens)
+    : lexer(std::string_view()), streaming(false), tokens(std::move(tokens)) {
+  if (this->tokens.size() == 0 ||
+      this->tokens.kind(this->tokens.size() - 1) != TokenKind::Eof)
+    throw std::logic_error("expected tokens ending with eof");
+  current_token = this->tokens[0];
+}
 
 int Parser::get_prec() {
-  if (binop_prec.count(current_token.second) == 0)
+  auto op = std::get_if<ast::Op>(&current_token.value);
+  if (op == nullptr)
     return -1;
-  int prec = binop_prec[current_token.second];
-  return prec;
+  return ast::binary_prec(*op);
+}
+
+Token Parser::next_token() {
+  if (!streaming) {
+    if (token_index + 1 < tokens.size())
+      token_index++;
+    return current_token = tokens[token_index];
+  }
+  if (lookahead) {
+    current_token = *lookahead;
+    lookahead.reset();
+    return current_token;
+  }
+  return current_token = lexer.get_token();
 }
 
-Token Parser::next_token() { return current_token = lexer.get_token(); }
+Token Parser::peek(std::size_t n) {
+  if (!streaming)
+    return tokens[std::min(token_index + n, tokens.size() - 1)];
+  if (n == 0)
+    return current_token;
+  if (n > 1)
+    throw std::logic_error("only one token of lookahead when streaming");
+  if (!lookahead) {
+    current_text = current_token.text;
+    current_token.text = current_text;
+    lookahead = current_token.kind == TokenKind::Eof ? current_token
+                                                     : lexer.get_token();
+  }
+  return *lookahead;
+}
 
 ast::LiteralExprNode<int> Parser::parse_int() {
-  ast::LiteralExprNode<int> node(std::stoi(current_token.second));
+  auto value = std::get<std::int64_t>(current_token.value);
+  if (value > std::numeric_limits<int>::max())
+    throw std::logic_error(
+        fmt::format("int literal out of range: {}", current_token.text));
+  ast::LiteralExprNode<int> node(static_cast<int>(value));
   next_token();
   return node;
 }
 
 ast::LiteralExprNode<double> Parser::parse_float() {
-  ast::LiteralExprNode<double> node(std::stod(current_token.second));
+  ast::LiteralExprNode<double> node(std::get<double>(current_token.value));
   next_token();
   return node;
 }
 
 ast::LiteralExprNode<bool> Parser::parse_bool() {
-  ast::LiteralExprNode<bool> node(current_token.second == "true");
+  ast::LiteralExprNode<bool> node(current_token.text == "true");
   next_token();
   return node;
 }
@@ -49,14 +105,14 @@ ast::ExprNode Parser::parse_expr() {
 ast::ExprNode Parser::parse_paren_expr() {
   next_token();
   auto node = parse_expr();
-  if (current_token.second != ")")
+  if (current_token.text != ")")
     throw std::logic_error("expected )");
   next_token();
   return node;
 }
 
 ast::ExprNode Parser::parse_primary() {
-  switch (current_token.first) {
+  switch (current_token.kind) {
   case TokenKind::Identifier:
     return parse_identifier_or_func_call();
   case TokenKind::Int:
@@ -66,7 +122,7 @@ ast::ExprNode Parser::parse_primary() {
   case TokenKind::Bool:
     return parse_bool();
   case TokenKind::Misc:
-    if (current_token.second == "(")
+    if (current_token.text == "(")
       return parse_paren_expr();
   default:
     throw std::logic_error("unknown token");
@@ -74,11 +130,12 @@ ast::ExprNode Parser::parse_primary() {
 }
 
 ast::ExprNode Parser::parse_unary_expr() {
-  if (unary_ops.count(current_token.second)) {
-    auto op = current_token;
+  auto op = std::get_if<ast::Op>(&current_token.value);
+  if (op != nullptr && ast::is_unary_op(*op)) {
+    ast::Op unary_op = *op;
     next_token();
     auto rhs = parse_unary_expr();
-    return std::make_unique<ast::UnaryExprNode>(op.second, std::move(rhs));
+    return std::make_unique<ast::UnaryExprNode>(unary_op, std::move(rhs));
   }
   return parse_primary();
 }
@@ -89,28 +146,28 @@ ast::ExprNode Parser::parse_binop_rhs(int expr_prec, ast::ExprNode lhs) {
     if (token_prec < expr_prec)
       return lhs;
 
-    auto op = current_token;
+    auto op = std::get<ast::Op>(current_token.value);
     next_token();
 
     auto rhs = std::move(parse_unary_expr());
     int next_prec = get_prec();
     if (token_prec < next_prec)
       rhs = parse_binop_rhs(token_prec + 1, std::move(rhs));
-    lhs = std::make_unique<ast::BinaryExprNode>(op.second, std::move(lhs),
+    lhs = std::make_unique<ast::BinaryExprNode>(op, std::move(lhs),
                                                 std::move(rhs));
   }
 }
 
 std::vector<ast::ExprNode> Parser::parse_call_arg_list() {
   std::vector<ast::ExprNode> args;
-  if (current_token.second != ")") {
+  if (current_token.text != ")") {
     while (true) {
       auto arg = parse_expr();
       args.push_back(std::move(arg));
 
-      if (current_token.second == ")")
+      if (current_token.text == ")")
         break;
-      if (current_token.second != ",")
+      if (current_token.text != ",")
         throw std::logic_error("expected ) or , in arg list");
       next_token();
     }
@@ -120,9 +177,9 @@ std::vector<ast::ExprNode> Parser::parse_call_arg_list() {
 }
 
 ast::ExprNode Parser::parse_identifier_or_func_call() {
-  std::string identifier = current_token.second;
+  util::Symbol identifier(current_token.text);
   next_token();
-  if (current_token.second != "(")
+  if (current_token.text != "(")
     return ast::VariableExprNode(identifier);
 
   next_token();
@@ -131,7 +188,7 @@ ast::ExprNode Parser::parse_identifier_or_func_call() {
 }
 
 ast::StmtNode Parser::parse_stmt() {
-  switch (current_token.first) {
+  switch (current_token.kind) {
   case TokenKind::Let:
     return parse_let();
   case TokenKind::Identifier:
@@ -155,27 +212,24 @@ ast::StmtNode Parser::parse_stmt() {
 
 ast::StmtNode Parser::parse_let() {
   next_token();
-  auto var_name = current_token.second;
-  next_token();
-  next_token();
-  auto type_name = current_token.second;
+  util::Symbol var_name(current_token.text);
+  if (next_token().text != ":")
+    throw std::logic_error("expected : after variable name");
+  types::TypeId var_type(next_token().text);
   next_token();
-  return ast::LetStmtNode(var_name, type_name);
+  return ast::LetStmtNode(var_name, var_type);
 }
 
 ast::StmtNode Parser::parse_assign_or_call() {
-  auto var_name = current_token.second;
-  next_token();
-  if (current_token.second == "=") {
+  auto next = peek();
+  if (next.text == "=") {
+    util::Symbol var_name(current_token.text);
+    next_token();
     next_token();
     auto expr = parse_expr();
     return ast::AssignmentStmtNode(var_name, std::move(expr));
-  } else if (current_token.second == "(") {
-    next_token();
-    return ast::AssignmentStmtNode(
-        "_", std::make_unique<ast::CallExprNode>(
-                 var_name, std::move(parse_call_arg_list())));
-  }
+  } else if (next.text == "(")
+    return ast::AssignmentStmtNode("_", parse_identifier_or_func_call());
   throw std::logic_error("expected assignment or function call");
 }
 
@@ -183,7 +237,7 @@ ast::StmtNode Parser::parse_if() {
   next_token();
   auto condition = parse_expr();
   auto then_stmt = parse_compound();
-  if (current_token.first != TokenKind::Else) {
+  if (current_token.kind != TokenKind::Else) {
     return std::make_unique<ast::IfStmtNode>(
         std::move(condition), std::move(then_stmt),
         std::make_unique<ast::CompoundStmtNode>(std::vector<ast::StmtNode>()));
@@ -222,7 +276,7 @@ ast::StmtNode Parser::parse_return() {
 ast::StmtNode Parser::parse_compound() {
   next_token();
   std::vector<ast::StmtNode> stmts;
-  while (current_token.second != "}") {
+  while (current_token.text != "}") {
     stmts.push_back(parse_stmt());
   }
   next_token();
@@ -230,30 +284,30 @@ ast::StmtNode Parser::parse_compound() {
 }
 
 ast::PrototypeNode Parser::parse_proto() {
-  if (current_token.first != TokenKind::Identifier)
+  if (current_token.kind != TokenKind::Identifier)
     throw std::logic_error("expected function name");
 
-  std::string func_name = current_token.second;
+  util::Symbol func_name(current_token.text);
   next_token();
 
-  if (current_token.second != "(")
+  if (current_token.text != "(")
     throw std::logic_error("expected ( in prototype");
 
-  std::vector<std::pair<std::string, std::string>> arg_names;
-  while (next_token().first == TokenKind::Identifier) {
-    auto var_name = current_token.second;
-    if (next_token().second != ":")
+  std::vector<std::pair<util::Symbol, types::TypeId>> arg_names;
+  while (next_token().kind == TokenKind::Identifier) {
+    util::Symbol var_name(current_token.text);
+    if (next_token().text != ":")
       throw std::logic_error("expected : after arg name");
-    auto type_name = next_token().second;
-    arg_names.push_back({var_name, type_name});
-    if (next_token().second != ",")
+    types::TypeId var_type(next_token().text);
+    arg_names.push_back({var_name, var_type});
+    if (next_token().text != ",")
       break;
   }
-  if (current_token.second != ")")
+  if (current_token.text != ")")
     throw std::logic_error("expected ) in prototype");
-  if (next_token().second != ":")
+  if (next_token().text != ":")
     throw std::logic_error("expected : after args");
-  auto return_type = next_token().second;
+  types::TypeId return_type(next_token().text);
   next_token();
   return ast::PrototypeNode(func_name, std::move(arg_names), return_type);
 }
@@ -275,11 +329,11 @@ ast::FunctionDeclNode Parser::parse_extern() {
 std::vector<ast::DeclNode> Parser::parse_all() {
   std::vector<ast::DeclNode> decls;
   while (true) {
-    if (current_token.first == TokenKind::Eof)
+    if (current_token.kind == TokenKind::Eof)
       return decls;
-    else if (current_token.first == TokenKind::Def)
+    else if (current_token.kind == TokenKind::Def)
       decls.push_back(std::move(parse_def()));
-    else if (current_token.first == TokenKind::Extern)
+    else if (current_token.kind == TokenKind::Extern)
       decls.push_back(std::move(parse_extern()));
     else
       throw std::logic_error("expected declaration");
@@ -287,12 +341,14 @@ std::vector<ast::DeclNode> Parser::parse_all() {
 }
 
 ast::Module Parser::parse_module() {
-  if (current_token.first != TokenKind::Module)
+  if (current_token.kind != TokenKind::Module)
     throw std::logic_error("expected module");
   next_token();
-  std::string name = current_token.second;
+  std::string name(current_token.text);
   next_token();
+  auto arena = std::make_unique<util::Arena>();
+  util::Arena::Scope arena_scope(arena.get());
   std::vector<ast::DeclNode> decls = parse_all();
-  return ast::Module(name, std::move(decls));
+  return ast::Module(name, std::move(decls), std::move(arena));
 }
 } // namespace stapl::parsing
@@ -0,0 +1,823 @@
+#include "range.h"
+#include "ast.h"
+#include "flat_ast.h"
+#include "ops.h"
+#include "scope.h"
+#include "symbol.h"
+#include "types.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace stapl::analysis {
+namespace {
+constexpr std::int64_t int_min = std::numeric_limits<std::int32_t>::min();
+constexpr std::int64_t int_max = std::numeric_limits<std::int32_t>::max();
+constexpr std::int64_t uint_max = std::numeric_limits<std::uint32_t>::max();
+
+/**
+ * @brief Get the interval of exact results of an arithmetic operation.
+ * @param op The operator.
+ * @param lhs Range of the LHS operand.
+ * @param rhs Range of the RHS operand.
+ * @return The bounds of the results computed without overflow, or
+ * ``std::nullopt`` for operators other than ``Add``, ``Sub`` and ``Mul``.
+ */
+std::optional<Interval> exact_result(ast::Op op, const Interval &lhs,
+                                     const Interval &rhs) {
+  switch (op) {
+  case ast::Op::Add:
+    return Interval{lhs.lo + rhs.lo, lhs.hi + rhs.hi};
+  case ast::Op::Sub:
+    return Interval{lhs.lo - rhs.hi, lhs.hi - rhs.lo};
+  case ast::Op::Mul: {
+    std::int64_t corners[] = {lhs.lo * rhs.lo, lhs.lo * rhs.hi,
+                              lhs.hi * rhs.lo, lhs.hi * rhs.hi};
+    return Interval{*std::min_element(std::begin(corners), std::end(corners)),
+                    *std::max_element(std::begin(corners), std::end(corners))};
+  }
+  default:
+    return std::nullopt;
+  }
+}
+
+/**
+ * @brief Get the range of an ``int`` result, which is full if it may
+ * overflow.
+ */
+Interval wrap(const Interval &result) {
+  if (result.lo < int_min || result.hi > int_max)
+    return {};
+  return result;
+}
+
+Interval eval_unary(ast::Op op, const Interval &rhs) {
+  if (op == ast::Op::Add)
+    return rhs;
+  if (op == ast::Op::Sub)
+    return wrap({-rhs.hi, -rhs.lo});
+  return {};
+}
+
+Interval eval_binary(ast::Op op, const Interval &lhs, const Interval &rhs) {
+  if (auto result = exact_result(op, lhs, rhs))
+    return wrap(*result);
+  if (op == ast::Op::Div) {
+    // Division truncates towards zero, so it is monotonic in each operand as
+    // long as the divisor keeps its sign, and the bounds are at the corners.
+    // The only overflowing quotient, INT_MIN / -1, is caught by ``wrap``.
+    if (rhs.contains(0))
+      return {};
+    std::int64_t corners[] = {lhs.lo / rhs.lo, lhs.lo / rhs.hi,
+                              lhs.hi / rhs.lo, lhs.hi / rhs.hi};
+    return wrap({*std::min_element(std::begin(corners), std::end(corners)),
+                 *std::max_element(std::begin(corners), std::end(corners))});
+  }
+  if (op == ast::Op::Mod) {
+    // The remainder is smaller than the divisor in magnitude and has the sign
+    // of the dividend.
+    if (rhs == Interval{0, 0})
+      return {};
+    auto bound = std::max(-rhs.lo, rhs.hi) - 1;
+    return {std::max(std::min<std::int64_t>(lhs.lo, 0), -bound),
+            std::min(std::max<std::int64_t>(lhs.hi, 0), bound)};
+  }
+  return {};
+}
+
+bool is_comparison(ast::Op op) {
+  switch (op) {
+  case ast::Op::Eq:
+  case ast::Op::Ne:
+  case ast::Op::Lt:
+  case ast::Op::Gt:
+  case ast::Op::Le:
+  case ast::Op::Ge:
+    return true;
+  default:
+    return false;
+  }
+}
+
+/**
+ * @brief Get the comparison which holds when ``op`` does not.
+ */
+ast::Op negate(ast::Op op) {
+  switch (op) {
+  case ast::Op::Eq:
+    return ast::Op::Ne;
+  case ast::Op::Ne:
+    return ast::Op::Eq;
+  case ast::Op::Lt:
+    return ast::Op::Ge;
+  case ast::Op::Ge:
+    return ast::Op::Lt;
+  case ast::Op::Gt:
+    return ast::Op::Le;
+  default:
+    return ast::Op::Gt;
+  }
+}
+
+/**
+ * @brief Get the comparison which holds with the operands swapped.
+ */
+ast::Op swap_operands(ast::Op op) {
+  switch (op) {
+  case ast::Op::Lt:
+    return ast::Op::Gt;
+  case ast::Op::Gt:
+    return ast::Op::Lt;
+  case ast::Op::Le:
+    return ast::Op::Ge;
+  case ast::Op::Ge:
+    return ast::Op::Le;
+  default:
+    return op;
+  }
+}
+
+/**
+ * @brief Narrow the range of the LHS of a comparison which holds.
+ * @return The narrowed range, or ``std::nullopt`` if the comparison cannot
+ * hold.
+ */
+std::optional<Interval> constrain(Interval lhs, ast::Op op,
+                                  const Interval &rhs) {
+  switch (op) {
+  case ast::Op::Eq:
+    lhs.lo = std::max(lhs.lo, rhs.lo);
+    lhs.hi = std::min(lhs.hi, rhs.hi);
+    break;
+  case ast::Op::Ne:
+    if (rhs.lo == rhs.hi && lhs.lo == rhs.lo)
+      lhs.lo++;
+    else if (rhs.lo == rhs.hi && lhs.hi == rhs.hi)
+      lhs.hi--;
+    break;
+  case ast::Op::Lt:
+    lhs.hi = std::min(lhs.hi, rhs.hi - 1);
+    break;
+  case ast::Op::Gt:
+    lhs.lo = std::max(lhs.lo, rhs.lo + 1);
+    break;
+  case ast::Op::Le:
+    lhs.hi = std::min(lhs.hi, rhs.hi);
+    break;
+  case ast::Op::Ge:
+    lhs.lo = std::max(lhs.lo, rhs.lo);
+    break;
+  default:
+    break;
+  }
+  if (lhs.lo > lhs.hi)
+    return std::nullopt;
+  return lhs;
+}
+
+/**
+ * @brief Abstract state at a program point.
+ */
+struct State {
+  /**
+   * @brief Ranges of the variables in scope. Variables of types other than
+   * ``int`` have the full range.
+   */
+  util::ScopeStack<Interval> vars;
+
+  /**
+   * @brief Whether the program point may be reached.
+   */
+  bool reachable = true;
+};
+
+/**
+ * @brief Join two states of the same program point.
+ */
+State join(State lhs, const State &rhs) {
+  if (!rhs.reachable)
+    return lhs;
+  if (!lhs.reachable)
+    return rhs;
+  for (std::size_t i = 0; i < lhs.vars.size(); i++)
+    lhs.vars[i] = lhs.vars[i].join(rhs.vars[i]);
+  return lhs;
+}
+
+/**
+ * @brief Check if a state includes another one of the same program point.
+ */
+bool includes(const State &lhs, const State &rhs) {
+  if (!rhs.reachable)
+    return true;
+  if (!lhs.reachable)
+    return false;
+  for (std::size_t i = 0; i < lhs.vars.size(); i++)
+    if (lhs.vars[i].join(rhs.vars[i]) != lhs.vars[i])
+      return false;
+  return true;
+}
+
+/**
+ * @brief Widen a loop head state, sending every growing bound to the bound of
+ * ``int``, so that each variable can grow at most twice.
+ */
+State widen(State head, const State &next) {
+  if (!head.reachable)
+    return next;
+  for (std::size_t i = 0; i < head.vars.size(); i++) {
+    if (next.vars[i].lo < head.vars[i].lo)
+      head.vars[i].lo = int_min;
+    if (next.vars[i].hi > head.vars[i].hi)
+      head.vars[i].hi = int_max;
+  }
+  return head;
+}
+
+/**
+ * @brief Close scopes until a given depth is reached.
+ */
+void pop_to(State &state, std::size_t depth) {
+  while (state.vars.depth() > depth)
+    state.vars.pop_scope();
+}
+
+/**
+ * @brief Abstract interpreter of function bodies over intervals, shared by
+ * the tree and the flat AST.
+ *
+ * ``Derived`` provides ``Interval eval(Expr)``, which records the ranges of
+ * the subexpressions while ``recording`` is set, ``void refine(Expr, bool)``,
+ * which narrows ``state`` by the outcome of a condition, and ``void
+ * exec(Stmt)``.
+ */
+template <typename Derived, typename Expr, typename Stmt> class Interpreter {
+protected:
+  /**
+   * @brief States at the jumps out of a loop.
+   */
+  struct LoopExits {
+    /**
+     * @brief Scope depth of the loop statement.
+     */
+    std::size_t depth;
+
+    /**
+     * @brief Join of the states at ``break`` statements.
+     */
+    State breaks;
+
+    /**
+     * @brief Join of the states at ``continue`` statements.
+     */
+    State continues;
+  };
+
+  /**
+   * @brief The current state.
+   */
+  State state;
+
+  /**
+   * @brief Whether expression ranges are recorded. Off while iterating a loop
+   * to its fixpoint, as states before the fixpoint do not hold.
+   */
+  bool recording = true;
+
+  /**
+   * @brief Exits of the loops enclosing the current statement.
+   */
+  std::vector<LoopExits> loops;
+
+  Derived &derived() { return static_cast<Derived &>(*this); }
+
+  void enter_function(const ast::PrototypeNode &proto) {
+    state = {};
+    loops.clear();
+    for (const auto &arg : proto.args)
+      state.vars.define(arg.first, {});
+  }
+
+  void define(util::Symbol name, types::TypeId type) {
+    // Variables are zero-initialized.
+    state.vars.define(name, type == types::int_type ? Interval{0, 0}
+                                                    : Interval{});
+  }
+
+  void assign(util::Symbol name, const Interval &value) {
+    if (auto *slot = state.vars.lookup(name))
+      *slot = value;
+  }
+
+  Interval variable(util::Symbol name) const {
+    const auto *value = state.vars.lookup(name);
+    return value != nullptr ? *value : Interval{};
+  }
+
+  /**
+   * @brief Narrow the variables compared by a condition.
+   * @param op The comparison operator.
+   * @param lhs_var The variable on the LHS, if the LHS is a variable.
+   * @param lhs Range of the LHS.
+   * @param rhs_var The variable on the RHS, if the RHS is a variable.
+   * @param rhs Range of the RHS.
+   * @param truth The outcome of the comparison.
+   */
+  void refine_comparison(ast::Op op, std::optional<util::Symbol> lhs_var,
+                         const Interval &lhs,
+                         std::optional<util::Symbol> rhs_var,
+                         const Interval &rhs, bool truth) {
+    if (!truth)
+      op = negate(op);
+    auto narrow = [&](util::Symbol name, std::optional<Interval> value) {
+      if (!value)
+        state.reachable = false;
+      else
+        assign(name, *value);
+    };
+    if (lhs_var)
+      narrow(*lhs_var, constrain(lhs, op, rhs));
+    if (rhs_var && state.reachable)
+      narrow(*rhs_var, constrain(rhs, swap_operands(op), lhs));
+  }
+
+  void exec_scoped(Stmt stmt) {
+    auto depth = state.vars.depth();
+    state.vars.push_scope();
+    derived().exec(stmt);
+    pop_to(state, depth);
+  }
+
+  void exec_if(Expr condition, Stmt then_stmt, Stmt else_stmt) {
+    derived().eval(condition);
+    State else_state = state;
+    derived().refine(condition, true);
+    exec_scoped(then_stmt);
+    std::swap(state, else_state);
+    derived().refine(condition, false);
+    exec_scoped(else_stmt);
+    state = join(std::move(state), else_state);
+  }
+
+  /**
+   * @brief Run one iteration of a loop from a head state.
+   * @return The states flowing back to the head and out of the loop through
+   * ``break``.
+   */
+  std::pair<State, State> iterate(Expr condition, Stmt body,
+                                  const State &head) {
+    state = head;
+    derived().eval(condition);
+    derived().refine(condition, true);
+    State unreachable = state;
+    unreachable.reachable = false;
+    loops.push_back({state.vars.depth(), unreachable, unreachable});
+    if (state.reachable)
+      exec_scoped(body);
+    auto exits = std::move(loops.back());
+    loops.pop_back();
+    return {join(std::move(state), exits.continues), std::move(exits.breaks)};
+  }
+
+  void exec_while(Expr condition, Stmt body) {
+    State entry = state;
+    bool was_recording = recording;
+    recording = false;
+
+    // Iterate to a post-fixpoint, widening after two iterations so that
+    // counters do not take one iteration per value, then narrow once to
+    // recover the bounds implied by the loop condition.
+    State head = entry;
+    for (int iteration = 0;; iteration++) {
+      auto next = join(entry, iterate(condition, body, head).first);
+      if (includes(head, next))
+        break;
+      head = iteration < 2 ? join(std::move(head), next) : widen(head, next);
+    }
+    head = join(entry, iterate(condition, body, head).first);
+
+    recording = was_recording;
+    auto breaks = iterate(condition, body, head).second;
+    state = std::move(head);
+    derived().refine(condition, false);
+    state = join(std::move(state), breaks);
+  }
+
+  void jump(bool is_break) {
+    if (!loops.empty()) {
+      auto &exits = loops.back();
+      State exit = state;
+      pop_to(exit, exits.depth);
+      auto &target = is_break ? exits.breaks : exits.continues;
+      target = join(std::move(target), exit);
+    }
+    state.reachable = false;
+  }
+};
+
+types::TypeId expr_type(const ast::ExprNode &expr) {
+  return std::visit(
+      [](const auto &node) {
+        if constexpr (requires { node->expr_type; })
+          return node->expr_type.value_or(types::TypeId());
+        else
+          return node.expr_type.value_or(types::TypeId());
+      },
+      expr);
+}
+
+class TreeInterpreter
+    : public Interpreter<TreeInterpreter, const ast::ExprNode &,
+                         const ast::StmtNode &> {
+private:
+  RangeFacts &facts;
+
+  void record(const void *key, const Interval &value) {
+    if (!recording || !state.reachable)
+      return;
+    auto [it, inserted] = facts.ranges.try_emplace(key, value);
+    if (!inserted)
+      it->second = it->second.join(value);
+  }
+
+public:
+  explicit TreeInterpreter(RangeFacts &facts) : facts(facts) {}
+
+  Interval eval(const ast::ExprNode &expr) { return std::visit(*this, expr); }
+
+  void refine(const ast::ExprNode &condition, bool truth) {
+    if (!state.reachable)
+      return;
+    if (const auto *literal =
+            std::get_if<ast::LiteralExprNode<bool>>(&condition)) {
+      if (literal->value != truth)
+        state.reachable = false;
+      return;
+    }
+    if (const auto *unary =
+            std::get_if<std::unique_ptr<ast::UnaryExprNode>>(&condition)) {
+      if ((*unary)->op == ast::Op::Not)
+        refine((*unary)->rhs, !truth);
+      return;
+    }
+    const auto *binary =
+        std::get_if<std::unique_ptr<ast::BinaryExprNode>>(&condition);
+    if (binary == nullptr || !is_comparison((*binary)->op) ||
+        expr_type((*binary)->lhs) != types::int_type ||
+        expr_type((*binary)->rhs) != types::int_type)
+      return;
+
+    auto variable_name =
+        [](const ast::ExprNode &expr) -> std::optional<util::Symbol> {
+      if (const auto *var = std::get_if<ast::VariableExprNode>(&expr))
+        return var->name;
+      return std::nullopt;
+    };
+    bool was_recording = recording;
+    recording = false;
+    auto lhs = eval((*binary)->lhs), rhs = eval((*binary)->rhs);
+    recording = was_recording;
+    refine_comparison((*binary)->op, variable_name((*binary)->lhs), lhs,
+                      variable_name((*binary)->rhs), rhs, truth);
+  }
+
+  void exec(const ast::StmtNode &stmt) {
+    if (state.reachable)
+      std::visit(*this, stmt);
+  }
+
+  Interval operator()(const ast::LiteralExprNode<int> &node) {
+    Interval value{node.value, node.value};
+    record(&node, value);
+    return value;
+  }
+
+  Interval operator()(const ast::LiteralExprNode<double> &node) { return {}; }
+
+  Interval operator()(const ast::LiteralExprNode<bool> &node) { return {}; }
+
+  Interval operator()(const ast::VariableExprNode &node) {
+    if (node.expr_type != types::int_type)
+      return {};
+    auto value = variable(node.name);
+    record(&node, value);
+    return value;
+  }
+
+  Interval operator()(const std::unique_ptr<ast::UnaryExprNode> &node) {
+    auto rhs = eval(node->rhs);
+    if (node->expr_type != types::int_type)
+      return {};
+    auto value = eval_unary(node->op, rhs);
+    record(node.get(), value);
+    return value;
+  }
+
+  Interval operator()(const std::unique_ptr<ast::BinaryExprNode> &node) {
+    auto lhs = eval(node->lhs), rhs = eval(node->rhs);
+    if (node->expr_type != types::int_type)
+      return {};
+    auto value = eval_binary(node->op, lhs, rhs);
+    record(node.get(), value);
+    return value;
+  }
+
+  Interval operator()(const std::unique_ptr<ast::CallExprNode> &node) {
+    for (const auto &arg : node->args)
+      eval(arg);
+    return {};
+  }
+
+  void operator()(const ast::LetStmtNode &node) {
+    define(node.var_name, node.var_type);
+  }
+
+  void operator()(const ast::AssignmentStmtNode &node) {
+    assign(node.var_name, eval(node.assign_expr));
+  }
+
+  void operator()(const std::unique_ptr<ast::IfStmtNode> &node) {
+    exec_if(node->condition, node->then_stmt, node->else_stmt);
+  }
+
+  void operator()(const std::unique_ptr<ast::WhileStmtNode> &node) {
+    exec_while(node->condition, node->body);
+  }
+
+  void operator()(const ast::BreakStmtNode &node) { jump(true); }
+
+  void operator()(const ast::ContinueStmtNode &node) { jump(false); }
+
+  void operator()(const ast::ReturnStmtNode &node) {
+    eval(node.return_expr);
+    state.reachable = false;
+  }
+
+  void operator()(const std::unique_ptr<ast::CompoundStmtNode> &node) {
+    auto depth = state.vars.depth();
+    state.vars.push_scope();
+    for (const auto &stmt : node->stmts)
+      exec(stmt);
+    pop_to(state, depth);
+  }
+
+  void operator()(const ast::FunctionDeclNode &node) {
+    if (!node.func_body.has_value())
+      return;
+    enter_function(node.proto);
+    exec(node.func_body.value());
+  }
+};
+
+class FlatInterpreter
+    : public Interpreter<FlatInterpreter, ast::IndexRange, ast::FlatStmtRef> {
+private:
+  const ast::FlatModule &module;
+
+  RangeFacts &facts;
+
+  /**
+   * @brief Whether a range is recorded for each node.
+   */
+  std::vector<bool> recorded;
+
+  /**
+   * @brief Ranges of the operands of the nodes being evaluated.
+   */
+  std::vector<Interval> operands;
+
+  void record(ast::NodeIndex index, const Interval &value) {
+    if (!recording || !state.reachable)
+      return;
+    auto &range = facts.flat_ranges[index];
+    range = recorded[index] ? range.join(value) : value;
+    recorded[index] = true;
+  }
+
+public:
+  FlatInterpreter(const ast::FlatModule &module, RangeFacts &facts)
+      : module(module), facts(facts), recorded(module.exprs.size()) {
+    facts.flat_ranges.assign(module.exprs.size(), {});
+  }
+
+  Interval eval(ast::IndexRange range) {
+    const auto &exprs = module.exprs;
+    auto operands_begin = operands.size();
+    for (auto i = range.begin; i < range.end; i++) {
+      auto payload = exprs.payloads[i];
+      bool is_int = exprs.types[i] == types::int_type;
+      Interval value;
+      switch (exprs.kinds[i]) {
+      case ast::FlatExprKind::Int: {
+        auto literal = std::bit_cast<std::int32_t>(payload);
+        value = {literal, literal};
+        break;
+      }
+      case ast::FlatExprKind::Float:
+      case ast::FlatExprKind::Bool:
+        break;
+      case ast::FlatExprKind::Variable:
+        if (is_int)
+          value = variable(util::Symbol::from_id(payload));
+        break;
+      case ast::FlatExprKind::Unary: {
+        auto rhs = operands.back();
+        operands.pop_back();
+        if (is_int)
+          value = eval_unary(static_cast<ast::Op>(payload), rhs);
+        break;
+      }
+      case ast::FlatExprKind::Binary: {
+        auto rhs = operands.back();
+        operands.pop_back();
+        auto lhs = operands.back();
+        operands.pop_back();
+        if (is_int)
+          value = eval_binary(static_cast<ast::Op>(payload), lhs, rhs);
+        break;
+      }
+      case ast::FlatExprKind::Call:
+        operands.resize(operands.size() - exprs.arities[i]);
+        is_int = false;
+        break;
+      }
+      if (is_int)
+        record(i, value);
+      operands.push_back(value);
+    }
+    auto value = operands.back();
+    operands.resize(operands_begin);
+    return value;
+  }
+
+  void refine(ast::IndexRange condition, bool truth) {
+    if (!state.reachable)
+      return;
+    const auto &exprs = module.exprs;
+    auto root = condition.end - 1;
+    auto op = static_cast<ast::Op>(exprs.payloads[root]);
+    if (exprs.kinds[root] == ast::FlatExprKind::Bool) {
+      if ((exprs.payloads[root] != 0) != truth)
+        state.reachable = false;
+      return;
+    }
+    if (exprs.kinds[root] == ast::FlatExprKind::Unary) {
+      if (op == ast::Op::Not)
+        refine({condition.begin, root}, !truth);
+      return;
+    }
+    if (exprs.kinds[root] != ast::FlatExprKind::Binary || !is_comparison(op))
+      return;
+    auto rhs_root = root - 1, lhs_root = exprs.subtree_begins[rhs_root] - 1;
+    if (exprs.types[lhs_root] != types::int_type ||
+        exprs.types[rhs_root] != types::int_type)
+      return;
+
+    auto variable_name =
+        [&](ast::IndexRange operand) -> std::optional<util::Symbol> {
+      if (operand.end - operand.begin == 1 &&
+          exprs.kinds[operand.begin] == ast::FlatExprKind::Variable)
+        return util::Symbol::from_id(exprs.payloads[operand.begin]);
+      return std::nullopt;
+    };
+    ast::IndexRange lhs_range{condition.begin, lhs_root + 1},
+        rhs_range{lhs_root + 1, root};
+    bool was_recording = recording;
+    recording = false;
+    auto lhs = eval(lhs_range), rhs = eval(rhs_range);
+    recording = was_recording;
+    refine_comparison(op, variable_name(lhs_range), lhs,
+                      variable_name(rhs_range), rhs, truth);
+  }
+
+  void exec(ast::FlatStmtRef stmt) {
+    if (!state.reachable)
+      return;
+    switch (stmt.kind) {
+    case ast::FlatStmtKind::Let: {
+      const auto &let = module.lets[stmt.index];
+      define(let.var_name, let.var_type);
+      break;
+    }
+    case ast::FlatStmtKind::Assignment: {
+      const auto &assignment = module.assignments[stmt.index];
+      assign(assignment.var_name, eval(assignment.assign_expr));
+      break;
+    }
+    case ast::FlatStmtKind::If: {
+      const auto &if_stmt = module.ifs[stmt.index];
+      exec_if(if_stmt.condition, if_stmt.then_stmt, if_stmt.else_stmt);
+      break;
+    }
+    case ast::FlatStmtKind::While: {
+      const auto &while_stmt = module.whiles[stmt.index];
+      exec_while(while_stmt.condition, while_stmt.body);
+      break;
+    }
+    case ast::FlatStmtKind::Break:
+      jump(true);
+      break;
+    case ast::FlatStmtKind::Continue:
+      jump(false);
+      break;
+    case ast::FlatStmtKind::Return:
+      eval(module.returns[stmt.index].return_expr);
+      state.reachable = false;
+      break;
+    case ast::FlatStmtKind::Compound: {
+      auto range = module.compounds[stmt.index].stmts;
+      auto depth = state.vars.depth();
+      state.vars.push_scope();
+      for (auto i = range.begin; i < range.end; i++)
+        exec(module.stmt_lists[i]);
+      pop_to(state, depth);
+      break;
+    }
+    }
+  }
+
+  void operator()(const ast::FlatFunction &func) {
+    if (!func.func_body.has_value())
+      return;
+    enter_function(func.proto);
+    exec(func.func_body.value());
+  }
+};
+} // namespace
+
+bool Interval::is_full() const { return lo <= int_min && hi >= int_max; }
+
+bool Interval::contains(std::int64_t value) const {
+  return lo <= value && value <= hi;
+}
+
+Interval Interval::join(const Interval &rhs) const {
+  return {std::min(lo, rhs.lo), std::max(hi, rhs.hi)};
+}
+
+WrapFlags wrap_flags(ast::Op op, const Interval &lhs, const Interval &rhs) {
+  if (op == ast::Op::Div) {
+    WrapFlags flags;
+    flags.exact = rhs == Interval{1, 1} || rhs == Interval{-1, -1} ||
+                  (lhs.lo == lhs.hi && rhs.lo == rhs.hi && rhs.lo != 0 &&
+                   lhs.lo % rhs.lo == 0);
+    return flags;
+  }
+  auto result = exact_result(op, lhs, rhs);
+  if (!result)
+    return {};
+  WrapFlags flags;
+  flags.nsw = result->lo >= int_min && result->hi <= int_max;
+  flags.nuw =
+      lhs.lo >= 0 && rhs.lo >= 0 && result->lo >= 0 && result->hi <= uint_max;
+  return flags;
+}
+
+bool division_may_trap(const Interval &lhs, const Interval &rhs) {
+  return rhs.contains(0) || (lhs.contains(int_min) && rhs.contains(-1));
+}
+
+const void *expr_key(const ast::ExprNode &expr) {
+  return std::visit(
+      [](const auto &node) -> const void * {
+        if constexpr (requires { node.get(); })
+          return node.get();
+        else
+          return &node;
+      },
+      expr);
+}
+
+Interval RangeFacts::range(const void *key) const {
+  auto it = ranges.find(key);
+  return it != ranges.end() ? it->second : Interval{};
+}
+
+Interval RangeFacts::flat_range(ast::NodeIndex index) const {
+  return index < flat_ranges.size() ? flat_ranges[index] : Interval{};
+}
+
+RangeFacts analyze_ranges(const ast::Module &module) {
+  RangeFacts facts;
+  TreeInterpreter interpreter(facts);
+  for (const auto &decl : module.decls)
+    std::visit(interpreter, decl);
+  return facts;
+}
+
+RangeFacts analyze_ranges(const ast::FlatModule &module) {
+  RangeFacts facts;
+  FlatInterpreter interpreter(module, facts);
+  for (const auto &func : module.functions)
+    interpreter(func);
+  return facts;
+}
+} // namespace stapl::analysis
@@ -0,0 +1,170 @@
+#include "scan.h"
+
+#include <cstddef>
+#include <string_view>
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define STAPL_SCAN_X86
+#include <immintrin.h>
+#endif
+
+namespace stapl::parsing::scan {
+namespace {
+enum class CharClass { Whitespace, Identifier, Number, LineEnd };
+
+// Scans over whitespace, identifiers and numbers skip characters of the class,
+// while a scan for the end of line stops at the first character of the class.
+template <CharClass C>
+constexpr bool stops_at_class = C == CharClass::LineEnd;
+
+constexpr bool in_range(unsigned char c, unsigned char lo, unsigned char span) {
+  return static_cast<unsigned char>(c - lo) <= span;
+}
+
+template <CharClass C> constexpr bool in_class(unsigned char c) {
+  if constexpr (C == CharClass::Whitespace)
+    return c == ' ' || in_range(c, '\t', '\r' - '\t');
+  else if constexpr (C == CharClass::Identifier)
+    return in_range(c, '0', 9) || in_range(c | 0x20, 'a', 25) || c == '_';
+  else if constexpr (C == CharClass::Number)
+    return in_range(c, '0', 9) || c == '.';
+  else
+    return c == '\n' || c == '\r' || c == '\0';
+}
+
+template <CharClass C>
+const char *scan_scalar(const char *p, const char *end) {
+  while (p != end &&
+         in_class<C>(static_cast<unsigned char>(*p)) != stops_at_class<C>)
+    p++;
+  return p;
+}
+
+#ifdef STAPL_SCAN_X86
+__m128i sse2_in_range(__m128i v, char lo, char span) {
+  __m128i offset = _mm_sub_epi8(v, _mm_set1_epi8(lo));
+  return _mm_cmpeq_epi8(_mm_min_epu8(offset, _mm_set1_epi8(span)), offset);
+}
+
+template <CharClass C> __m128i sse2_class_mask(__m128i v) {
+  if constexpr (C == CharClass::Whitespace)
+    return _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')),
+                        sse2_in_range(v, '\t', '\r' - '\t'));
+  else if constexpr (C == CharClass::Identifier)
+    return _mm_or_si128(
+        _mm_or_si128(sse2_in_range(v, '0', 9),
+                     sse2_in_range(_mm_or_si128(v, _mm_set1_epi8(0x20)), 'a',
+                                   25)),
+        _mm_cmpeq_epi8(v, _mm_set1_epi8('_')));
+  else if constexpr (C == CharClass::Number)
+    return _mm_or_si128(sse2_in_range(v, '0', 9),
+                        _mm_cmpeq_epi8(v, _mm_set1_epi8('.')));
+  else
+    return _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\n')),
+                                     _mm_cmpeq_epi8(v, _mm_set1_epi8('\r'))),
+                        _mm_cmpeq_epi8(v, _mm_setzero_si128()));
+}
+
+template <CharClass C> const char *scan_sse2(const char *p, const char *end) {
+  for (; end - p >= 16; p += 16) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+    unsigned in =
+        static_cast<unsigned>(_mm_movemask_epi8(sse2_class_mask<C>(v)));
+    unsigned stop = stops_at_class<C> ? in : ~in & 0xffffu;
+    if (stop != 0)
+      return p + __builtin_ctz(stop);
+  }
+  return scan_scalar<C>(p, end);
+}
+
+__attribute__((target("avx2"))) __m256i avx2_in_range(__m256i v, char lo,
+                                                      char span) {
+  __m256i offset = _mm256_sub_epi8(v, _mm256_set1_epi8(lo));
+  return _mm256_cmpeq_epi8(_mm256_min_epu8(offset, _mm256_set1_epi8(span)),
+                           offset);
+}
+
+template <CharClass C>
+__attribute__((target("avx2"))) __m256i avx2_class_mask(__m256i v) {
+  if constexpr (C == CharClass::Whitespace)
+    return _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')),
+                           avx2_in_range(v, '\t', '\r' - '\t'));
+  else if constexpr (C == CharClass::Identifier)
+    return _mm256_or_si256(
+        _mm256_or_si256(
+            avx2_in_range(v, '0', 9),
+            avx2_in_range(_mm256_or_si256(v, _mm256_set1_epi8(0x20)), 'a',
+                          25)),
+        _mm256_cmpeq_epi8(v, _mm256_set1_epi8('_')));
+  else if constexpr (C == CharClass::Number)
+    return _mm256_or_si256(avx2_in_range(v, '0', 9),
+                           _mm256_cmpeq_epi8(v, _mm256_set1_epi8('.')));
+  else
+    return _mm256_or_si256(
+        _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n')),
+                        _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\r'))),
+        _mm256_cmpeq_epi8(v, _mm256_setzero_si256()));
+}
+
+template <CharClass C>
+__attribute__((target("avx2"))) const char *scan_avx2(const char *p,
+                                                     const char *end) {
+  for (; end - p >= 32; p += 32) {
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+    unsigned in =
+        static_cast<unsigned>(_mm256_movemask_epi8(avx2_class_mask<C>(v)));
+    unsigned stop = stops_at_class<C> ? in : ~in;
+    if (stop != 0)
+      return p + __builtin_ctz(stop);
+  }
+  return scan_sse2<C>(p, end);
+}
+#endif
+
+template <CharClass C>
+std::size_t scan(std::string_view code, std::size_t pos, Isa isa) {
+  const char *begin = code.data(), *end = begin + code.size(), *p = begin + pos;
+  switch (isa) {
+#ifdef STAPL_SCAN_X86
+  case Isa::AVX2:
+    return scan_avx2<C>(p, end) - begin;
+  case Isa::SSE2:
+    return scan_sse2<C>(p, end) - begin;
+#endif
+  default:
+    return scan_scalar<C>(p, end) - begin;
+  }
+}
+} // namespace
+
+Isa detected_isa() {
+  static const Isa isa = [] {
+#ifdef STAPL_SCAN_X86
+    if (__builtin_cpu_supports("avx2"))
+      return Isa::AVX2;
+    return Isa::SSE2;
+#else
+    return Isa::Scalar;
+#endif
+  }();
+  return isa;
+}
+
+bool isa_supported(Isa isa) { return isa <= detected_isa(); }
+
+std::size_t skip_whitespace(std::string_view code, std::size_t pos, Isa isa) {
+  return scan<CharClass::Whitespace>(code, pos, isa);
+}
+
+std::size_t skip_identifier(std::string_view code, std::size_t pos, Isa isa) {
+  return scan<CharClass::Identifier>(code, pos, isa);
+}
+
+std::size_t skip_number(std::string_view code, std::size_t pos, Isa isa) {
+  return scan<CharClass::Number>(code, pos, isa);
+}
+
+std::size_t find_line_end(std::string_view code, std::size_t pos, Isa isa) {
+  return scan<CharClass::LineEnd>(code, pos, isa);
+}
+} // namespace stapl::parsing::scan
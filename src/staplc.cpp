@@ -1,8 +1,15 @@
 #include "annotator.h"
 #include "ast_printer.h"
+#include "effects.h"
+#include "flat_ast.h"
 #include "irgen.h"
+#include "jit.h"
+#include "optimizer.h"
 #include "parser.h"
+#include "range.h"
+#include "target.h"
 
+#include <cstdint>
 #include <exception>
 #include <fstream>
 #include <ios>
@@ -10,27 +17,89 @@
 #include <map>
 #include <memory>
 #include <sstream>
+#include <stdexcept>
 #include <string>
+#include <utility>
 #include <variant>
+#include <vector>
+
+#include <llvm/Support/Timer.h>
+#include <llvm/Support/raw_ostream.h>
 
 #include <boost/exception/all.hpp>
 #include <boost/program_options.hpp>
 
 namespace po = boost::program_options;
+using stapl::analysis::analyze_effects;
+using stapl::analysis::analyze_ranges;
+using stapl::analysis::effects_report;
 using stapl::ast::ASTPrinter;
+using stapl::ast::flatten;
+using stapl::analysis::EffectFacts;
+using stapl::analysis::RangeFacts;
+using stapl::ir::IntDivPolicy;
 using stapl::ir::IRGen;
+using stapl::ir::IRGenOptions;
+using stapl::jit::JIT;
+using stapl::jit::JITOptions;
+using stapl::opt::optimize_module;
+using stapl::opt::parse_opt_level;
+using stapl::opt::run_passes;
 using stapl::parsing::Parser;
-using stapl::types::TypeAnnotator;
+using stapl::parsing::TokenBuffer;
+using stapl::parsing::tokenize_parallel;
+using stapl::target::create_target_machine;
+using stapl::target::emit_file;
+using stapl::target::FileKind;
+using stapl::target::set_target;
+using stapl::target::TargetOptions;
+using stapl::types::annotate_module;
 
 int main(int argc, char *argv[]) {
   po::options_description desc("staplc -- Stapl Compiler");
   desc.add_options()("help", "produce help message")(
-      "emit-ir", po::value<std::string>(), "emit LLVM IR")("dump-ast",
-                                                           "print ast info");
+      "emit-ir", po::value<std::string>(), "emit LLVM IR")(
+      "emit-bc", po::value<std::string>(), "emit LLVM bitcode")(
+      "emit-obj", po::value<std::string>(), "emit a native object file")(
+      "emit-asm", po::value<std::string>(), "emit native assembly")(
+      "dump-ast", "print ast info")(
+      "jobs,j", po::value<unsigned>()->default_value(1),
+      "number of threads for lexing and type checking")(
+      "flat-ast", "type check and emit IR from the flat AST")(
+      "effects-report", "print the effects inferred for each function")(
+      "int-div", po::value<std::string>()->default_value("trap"),
+      "integer division by zero or overflow: trap or unchecked")(
+      "opt-level,O", po::value<std::string>()->default_value("0"),
+      "optimization level: 0, 1, 2, 3 or s")(
+      "passes", po::value<std::string>(),
+      "run a custom pass pipeline, as for opt -passes, instead of -O")(
+      "target", po::value<std::string>(),
+      "target triple of native code, the host if not given")(
+      "mcpu", po::value<std::string>(),
+      "target CPU of native code, or native for the host CPU")(
+      "time-phases", "print the time spent in each compiler phase")(
+      "run", "compile the module in a JIT and call the entry function with "
+             "the arguments after the input file, printing its result; put "
+             "-- before the arguments if one starts with -, as in "
+             "staplc --run f.stapl -- -5")(
+      "entry", po::value<std::string>()->default_value("main"),
+      "entry function called by --run")(
+      "lazy", "compile each function on its first call with --run")(
+      "jit-threads", po::value<unsigned>()->default_value(0),
+      "number of background compile threads with --run")(
+      "speculate", "compile functions the entry may call in the background "
+                   "before they are called, with --lazy")(
+      "jit-cache", po::value<std::string>(),
+      "directory caching objects compiled by --run across runs")(
+      "jit-cache-size", po::value<unsigned>()->default_value(512),
+      "maximum size of the --jit-cache directory in MiB");
   po::options_description hidden("Hidden");
-  hidden.add_options()("input-file", "input file");
+  hidden.add_options()("input-file", "input file")(
+      "args", po::value<std::vector<std::string>>(),
+      "arguments of the entry function");
   po::positional_options_description pos;
   pos.add("input-file", 1);
+  pos.add("args", -1);
   po::variables_map vmap;
   po::options_description cmdline_options;
   cmdline_options.add(desc).add(hidden);
@@ -54,26 +123,191 @@ int main(int argc, char *argv[]) {
     std::cerr << "No input specified" << std::endl;
     return 1;
   }
+  if (vmap.count("args") && !vmap.count("run")) {
+    std::cerr << "Unexpected argument: "
+              << vmap["args"].as<std::vector<std::string>>().front()
+              << std::endl;
+    return 1;
+  }
+  IRGenOptions irgen_options;
+  auto int_div = vmap["int-div"].as<std::string>();
+  if (int_div == "unchecked")
+    irgen_options.int_div = IntDivPolicy::Unchecked;
+  else if (int_div != "trap") {
+    std::cerr << "Unknown integer division mode: " << int_div << std::endl;
+    return 1;
+  }
+  auto opt_level = parse_opt_level(vmap["opt-level"].as<std::string>());
+  if (!opt_level) {
+    std::cerr << "Unknown optimization level: "
+              << vmap["opt-level"].as<std::string>() << std::endl;
+    return 1;
+  }
+  std::unique_ptr<llvm::TargetMachine> target_machine;
+  if (vmap.count("emit-obj") || vmap.count("emit-asm") ||
+      vmap.count("target") || vmap.count("mcpu")) {
+    TargetOptions target_options;
+    if (vmap.count("target"))
+      target_options.triple = vmap["target"].as<std::string>();
+    if (vmap.count("mcpu"))
+      target_options.cpu = vmap["mcpu"].as<std::string>();
+    target_options.opt_level = *opt_level;
+    try {
+      target_machine = create_target_machine(target_options);
+    } catch (const std::logic_error &err) {
+      std::cerr << "Cannot create target machine: " << err.what()
+                << std::endl;
+      return 1;
+    }
+  }
+
+  llvm::TimerGroup phase_timers("staplc", "Compiler phases");
+  llvm::Timer parse_timer("parse", "Parsing", phase_timers);
+  llvm::Timer annotate_timer("annotate", "Type checking", phase_timers);
+  llvm::Timer analyze_timer("analyze", "Range and effect analysis",
+                            phase_timers);
+  llvm::Timer irgen_timer("irgen", "IR generation", phase_timers);
+  llvm::Timer optimize_timer("optimize", "Optimization", phase_timers);
+  llvm::Timer emit_timer("emit", "Output", phase_timers);
+  llvm::Timer run_timer("run", "JIT compilation and execution", phase_timers);
+  bool time_phases = vmap.count("time-phases");
+  auto timed = [time_phases](llvm::Timer &timer) {
+    return time_phases ? &timer : nullptr;
+  };
 
   std::ifstream infile(vmap["input-file"].as<std::string>());
-  std::stringstream buf;
-  buf << infile.rdbuf();
-  auto parser = Parser(buf.str());
-  auto module = parser.parse_module();
+  if (!infile) {
+    std::cerr << "Cannot open input file" << std::endl;
+    return 1;
+  }
+  std::string code;
+  auto jobs = vmap["jobs"].as<unsigned>();
+  auto module = [&] {
+    llvm::TimeRegion region(timed(parse_timer));
+    std::unique_ptr<Parser> parser;
+    if (jobs > 1) {
+      std::stringstream buf;
+      buf << infile.rdbuf();
+      code = buf.str();
+      parser = std::make_unique<Parser>(
+          TokenBuffer(code, tokenize_parallel(code, jobs)));
+    } else
+      parser = std::make_unique<Parser>(infile);
+    return parser->parse_module();
+  }();
 
   if (vmap.count("dump-ast")) {
     ASTPrinter printer;
     for (auto &root : module.decls)
       std::cout << std::visit(printer, root) << std::endl;
-  } else if (vmap.count("emit-ir")) {
-    TypeAnnotator annotator;
-    for (auto &decl : module.decls)
-      std::visit(annotator, decl);
-    IRGen irgen;
-    irgen.codegen(module);
-    std::ofstream outfile(vmap["emit-ir"].as<std::string>());
-    irgen.write_ir(outfile);
+  } else if (vmap.count("emit-ir") || vmap.count("emit-bc") ||
+             vmap.count("emit-obj") || vmap.count("emit-asm") ||
+             vmap.count("effects-report") || vmap.count("run")) {
+    IRGen irgen(irgen_options);
+    bool checked_division = irgen_options.int_div == IntDivPolicy::Trap;
+    RangeFacts range_facts;
+    EffectFacts effect_facts;
+    if (vmap.count("flat-ast")) {
+      auto flat_module = [&] {
+        llvm::TimeRegion region(timed(annotate_timer));
+        auto flat_module = flatten(module);
+        annotate_module(flat_module, jobs);
+        return flat_module;
+      }();
+      {
+        llvm::TimeRegion region(timed(analyze_timer));
+        range_facts = analyze_ranges(flat_module);
+        effect_facts =
+            analyze_effects(flat_module, checked_division, &range_facts);
+      }
+      irgen.set_range_facts(range_facts);
+      irgen.set_effect_facts(effect_facts);
+      llvm::TimeRegion region(timed(irgen_timer));
+      irgen.codegen(flat_module);
+    } else {
+      {
+        llvm::TimeRegion region(timed(annotate_timer));
+        annotate_module(module, jobs);
+      }
+      {
+        llvm::TimeRegion region(timed(analyze_timer));
+        range_facts = analyze_ranges(module);
+        effect_facts =
+            analyze_effects(module, checked_division, &range_facts);
+      }
+      irgen.set_range_facts(range_facts);
+      irgen.set_effect_facts(effect_facts);
+      llvm::TimeRegion region(timed(irgen_timer));
+      irgen.codegen(module);
+    }
+    if (vmap.count("effects-report"))
+      std::cout << effects_report(effect_facts);
+    if (vmap.count("run")) {
+      JITOptions jit_options;
+      jit_options.opt_level = *opt_level;
+      jit_options.entry = vmap["entry"].as<std::string>();
+      jit_options.lazy = vmap.count("lazy");
+      jit_options.compile_threads = vmap["jit-threads"].as<unsigned>();
+      jit_options.speculate = vmap.count("speculate");
+      if (vmap.count("jit-cache"))
+        jit_options.cache_dir = vmap["jit-cache"].as<std::string>();
+      jit_options.cache_size =
+          static_cast<std::uintmax_t>(vmap["jit-cache-size"].as<unsigned>())
+          << 20;
+      std::vector<std::string> args;
+      if (vmap.count("args"))
+        args = vmap["args"].as<std::vector<std::string>>();
+      try {
+        llvm::TimeRegion region(timed(run_timer));
+        JIT jit(jit_options);
+        auto [context, llvm_module] = irgen.release_module();
+        jit.add_module(std::move(context), std::move(llvm_module));
+        if (auto result = jit.run(args))
+          std::cout << *result << std::endl;
+      } catch (const std::logic_error &err) {
+        std::cerr << "Cannot run " << jit_options.entry << ": " << err.what()
+                  << std::endl;
+        return 1;
+      }
+      if (time_phases)
+        phase_timers.print(llvm::errs(), true);
+      return 0;
+    }
+    auto &llvm_module = irgen.get_module();
+    if (target_machine)
+      set_target(llvm_module, *target_machine);
+    {
+      llvm::TimeRegion region(timed(optimize_timer));
+      if (vmap.count("passes")) {
+        try {
+          run_passes(llvm_module, vmap["passes"].as<std::string>(),
+                     target_machine.get());
+        } catch (const std::logic_error &err) {
+          std::cerr << "Invalid pass pipeline: " << err.what() << std::endl;
+          return 1;
+        }
+      } else
+        optimize_module(llvm_module, *opt_level, target_machine.get());
+    }
+    llvm::TimeRegion region(timed(emit_timer));
+    try {
+      if (vmap.count("emit-ir"))
+        irgen.write_ir(vmap["emit-ir"].as<std::string>());
+      if (vmap.count("emit-bc"))
+        irgen.write_bitcode(vmap["emit-bc"].as<std::string>());
+      if (vmap.count("emit-asm"))
+        emit_file(llvm_module, *target_machine,
+                  vmap["emit-asm"].as<std::string>(), FileKind::Assembly);
+      if (vmap.count("emit-obj"))
+        emit_file(llvm_module, *target_machine,
+                  vmap["emit-obj"].as<std::string>(), FileKind::Object);
+    } catch (const std::logic_error &err) {
+      std::cerr << "Cannot write output: " << err.what() << std::endl;
+      return 1;
+    }
   }
+  if (time_phases)
+    phase_timers.print(llvm::errs(), true);
 
   return 0;
 }
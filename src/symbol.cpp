@@ -0,0 +1,64 @@
+#include "symbol.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+
+namespace stapl::util {
+Symbol::Symbol() : symbol_id(0) {}
+
+Symbol::Symbol(std::string_view name)
+    : symbol_id(Interner::global().intern(name)) {}
+
+Symbol::Symbol(const char *name) : Symbol(std::string_view(name)) {}
+
+Symbol::Symbol(const std::string &name) : Symbol(std::string_view(name)) {}
+
+Symbol Symbol::from_id(std::uint32_t symbol_id) {
+  Symbol symbol;
+  symbol.symbol_id = symbol_id;
+  return symbol;
+}
+
+std::uint32_t Symbol::id() const { return symbol_id; }
+
+std::string_view Symbol::str() const {
+  return Interner::global().name(symbol_id);
+}
+
+Interner::Interner() { intern(""); }
+
+Interner &Interner::global() {
+  static Interner interner;
+  return interner;
+}
+
+std::uint32_t Interner::intern(std::string_view name) {
+  {
+    std::shared_lock read_lock(lock);
+    auto it = ids.find(name);
+    if (it != ids.end())
+      return it->second;
+  }
+  std::unique_lock write_lock(lock);
+  auto it = ids.find(name);
+  if (it != ids.end())
+    return it->second;
+  auto symbol_id = static_cast<std::uint32_t>(names.size());
+  ids.emplace(names.emplace_back(name), symbol_id);
+  return symbol_id;
+}
+
+std::string_view Interner::name(std::uint32_t symbol_id) const {
+  std::shared_lock read_lock(lock);
+  return names.at(symbol_id);
+}
+
+std::size_t Interner::size() const {
+  std::shared_lock read_lock(lock);
+  return names.size();
+}
+} // namespace stapl::util
@@ -0,0 +1,114 @@
+#include "target.h"
+#include "optimizer.h"
+
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+#include <llvm/ADT/StringMap.h>
+#include <llvm/IR/LegacyPassManager.h>
+#include <llvm/IR/Module.h>
+#include <llvm/MC/TargetRegistry.h>
+#include <llvm/Support/CodeGen.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/TargetSelect.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/Target/TargetMachine.h>
+#include <llvm/Target/TargetOptions.h>
+#include <llvm/TargetParser/Host.h>
+#include <llvm/TargetParser/Triple.h>
+
+#include <fmt/core.h>
+
+namespace stapl::target {
+namespace {
+void initialize_targets() {
+  static std::once_flag initialized;
+  std::call_once(initialized, [] {
+    llvm::InitializeAllTargetInfos();
+    llvm::InitializeAllTargets();
+    llvm::InitializeAllTargetMCs();
+    llvm::InitializeAllAsmPrinters();
+  });
+}
+
+std::string host_features() {
+  llvm::StringMap<bool> features;
+  if (!llvm::sys::getHostCPUFeatures(features))
+    return "";
+  std::string result;
+  for (const auto &feature : features) {
+    if (!result.empty())
+      result += ',';
+    result += feature.getValue() ? '+' : '-';
+    result += feature.getKey();
+  }
+  return result;
+}
+} // namespace
+
+llvm::CodeGenOpt::Level codegen_opt_level(opt::OptLevel level) {
+  switch (level) {
+  case opt::OptLevel::O0:
+    return llvm::CodeGenOpt::None;
+  case opt::OptLevel::O1:
+    return llvm::CodeGenOpt::Less;
+  case opt::OptLevel::O3:
+    return llvm::CodeGenOpt::Aggressive;
+  default:
+    return llvm::CodeGenOpt::Default;
+  }
+}
+
+std::unique_ptr<llvm::TargetMachine>
+create_target_machine(const TargetOptions &options) {
+  initialize_targets();
+  auto triple = options.triple.empty()
+                    ? llvm::sys::getDefaultTargetTriple()
+                    : llvm::Triple::normalize(options.triple);
+  std::string error;
+  const auto *target = llvm::TargetRegistry::lookupTarget(triple, error);
+  if (!target)
+    throw std::logic_error(
+        fmt::format("unsupported target {}: {}", triple, error));
+
+  std::string cpu = options.cpu.empty() ? "generic" : options.cpu;
+  std::string features;
+  if (cpu == "native") {
+    cpu = llvm::sys::getHostCPUName().str();
+    features = host_features();
+  }
+  return std::unique_ptr<llvm::TargetMachine>(target->createTargetMachine(
+      triple, cpu, features, llvm::TargetOptions(), llvm::Reloc::PIC_,
+      std::nullopt, codegen_opt_level(options.opt_level)));
+}
+
+void set_target(llvm::Module &module, const llvm::TargetMachine &machine) {
+  module.setTargetTriple(machine.getTargetTriple().str());
+  module.setDataLayout(machine.createDataLayout());
+}
+
+void emit_file(llvm::Module &module, llvm::TargetMachine &machine,
+               const std::string &path, FileKind kind) {
+  std::error_code ec;
+  llvm::raw_fd_ostream out(path, ec,
+                           kind == FileKind::Object ? llvm::sys::fs::OF_None
+                                                    : llvm::sys::fs::OF_Text);
+  if (ec)
+    throw std::logic_error(
+        fmt::format("cannot open output file {}: {}", path, ec.message()));
+
+  llvm::legacy::PassManager pass_manager;
+  auto file_type = kind == FileKind::Object ? llvm::CGFT_ObjectFile
+                                            : llvm::CGFT_AssemblyFile;
+  if (machine.addPassesToEmitFile(pass_manager, out, nullptr, file_type))
+    throw std::logic_error(
+        fmt::format("target {} cannot emit this kind of file",
+                    machine.getTargetTriple().str()));
+  pass_manager.run(module);
+  out.flush();
+}
+} // namespace stapl::target
@@ -0,0 +1,82 @@
+#include "token_buffer.h"
+#include "lexer.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+namespace stapl::parsing {
+namespace {
+void check_code_size(std::string_view code) {
+  if (code.size() >= std::numeric_limits<std::uint32_t>::max())
+    throw std::logic_error("code too large for token buffer");
+}
+} // namespace
+
+TokenBuffer::TokenBuffer(std::string_view code) : code(code) {
+  check_code_size(code);
+  Lexer lexer(code);
+  while (true) {
+    auto token = lexer.get_token();
+    push_back(token);
+    if (token.kind == TokenKind::Eof)
+      break;
+  }
+}
+
+TokenBuffer::TokenBuffer(std::string_view code,
+                         const std::vector<Token> &tokens)
+    : code(code) {
+  check_code_size(code);
+  kinds.reserve(tokens.size());
+  offsets.reserve(tokens.size());
+  lengths.reserve(tokens.size());
+  payload_indices.reserve(tokens.size());
+  for (const auto &token : tokens)
+    push_back(token);
+}
+
+void TokenBuffer::push_back(const Token &token) {
+  if (token.text.data() < code.data() ||
+      token.text.data() + token.text.size() > code.data() + code.size())
+    throw std::logic_error("token does not view into the code");
+  kinds.push_back(token.kind);
+  auto offset = static_cast<std::uint32_t>(token.text.data() - code.data());
+  offsets.push_back(offset);
+  lengths.push_back(static_cast<std::uint32_t>(token.text.size()));
+  if (std::holds_alternative<std::monostate>(token.value))
+    payload_indices.push_back(no_payload);
+  else {
+    payload_indices.push_back(static_cast<std::uint32_t>(payloads.size()));
+    payloads.push_back(token.value);
+  }
+}
+
+std::size_t TokenBuffer::size() const { return kinds.size(); }
+
+std::string_view TokenBuffer::get_code() const { return code; }
+
+TokenKind TokenBuffer::kind(std::size_t index) const { return kinds[index]; }
+
+std::size_t TokenBuffer::offset(std::size_t index) const {
+  return offsets[index];
+}
+
+std::string_view TokenBuffer::text(std::size_t index) const {
+  return code.substr(offsets[index], lengths[index]);
+}
+
+TokenValue TokenBuffer::value(std::size_t index) const {
+  if (payload_indices[index] == no_payload)
+    return {};
+  return payloads[payload_indices[index]];
+}
+
+Token TokenBuffer::operator[](std::size_t index) const {
+  return {kind(index), text(index), value(index)};
+}
+} // namespace stapl::parsing
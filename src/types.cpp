@@ -1,9 +1,74 @@
 #include "types.h"
+#include "symbol.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <shared_mutex>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace stapl::types {
-FuncTypeInfo::FuncTypeInfo(const std::vector<std::string> &arg_types,
-                           const std::string &return_type)
-    : arg_types(arg_types), return_type(return_type) {}
+TypeId::TypeId(std::string_view name)
+    : type_id(TypeTable::global().intern(name)) {}
+
+TypeId::TypeId(const char *name) : TypeId(std::string_view(name)) {}
+
+TypeId::TypeId(const std::string &name) : TypeId(std::string_view(name)) {}
+
+std::string_view TypeId::str() const {
+  return TypeTable::global().name(type_id);
+}
+
+TypeKind TypeId::kind() const { return TypeTable::global().kind(type_id); }
+
+TypeTable::TypeTable() {
+  intern("", TypeKind::None);
+  intern("void", TypeKind::Void);
+  intern("int", TypeKind::Int);
+  intern("float", TypeKind::Float);
+  intern("bool", TypeKind::Bool);
+}
+
+TypeTable &TypeTable::global() {
+  static TypeTable table;
+  return table;
+}
+
+std::uint32_t TypeTable::intern(util::Symbol name, TypeKind kind) {
+  {
+    std::shared_lock read_lock(lock);
+    auto it = ids.find(name);
+    if (it != ids.end())
+      return it->second;
+  }
+  std::unique_lock write_lock(lock);
+  auto it = ids.find(name);
+  if (it != ids.end())
+    return it->second;
+  auto type_id = static_cast<std::uint32_t>(types.size());
+  types.push_back({name, kind});
+  ids.emplace(name, type_id);
+  return type_id;
+}
+
+std::uint32_t TypeTable::intern(std::string_view name) {
+  return intern(util::Symbol(name), TypeKind::Named);
+}
+
+std::string_view TypeTable::name(std::uint32_t type_id) const {
+  std::shared_lock read_lock(lock);
+  return types.at(type_id).name.str();
+}
+
+TypeKind TypeTable::kind(std::uint32_t type_id) const {
+  std::shared_lock read_lock(lock);
+  return types.at(type_id).kind;
+}
+
+std::size_t TypeTable::size() const {
+  std::shared_lock read_lock(lock);
+  return types.size();
+}
 } // namespace stapl::types
@@ -0,0 +1,305 @@
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string_view>
+#include <variant>
+
+#include "annotator.h"
+#include "ast.h"
+#include "effects.h"
+#include "flat_ast.h"
+#include "ops.h"
+#include "parser.h"
+#include "range.h"
+#include "test_util.h"
+
+using namespace stapl::analysis;
+using namespace stapl::ast;
+using stapl::test_util::parse_annotated;
+using stapl::types::annotate_module;
+
+namespace {
+const std::vector<StmtNode> &body_stmts(const Module &module,
+                                        std::size_t index) {
+  const auto &func = std::get<FunctionDeclNode>(module.decls[index]);
+  return std::get<std::unique_ptr<CompoundStmtNode>>(func.func_body.value())
+      ->stmts;
+}
+
+const std::vector<StmtNode> &compound_stmts(const StmtNode &stmt) {
+  return std::get<std::unique_ptr<CompoundStmtNode>>(stmt)->stmts;
+}
+
+NodeIndex root(IndexRange range) { return range.end - 1; }
+} // namespace
+
+TEST(AnalysisTest, WrapFlags) {
+  auto flags = wrap_flags(Op::Add, {0, 10}, {0, 10});
+  EXPECT_TRUE(flags.nsw);
+  EXPECT_TRUE(flags.nuw);
+
+  flags = wrap_flags(Op::Sub, {0, 10}, {0, 5});
+  EXPECT_TRUE(flags.nsw);
+  EXPECT_FALSE(flags.nuw);
+
+  flags = wrap_flags(Op::Mul, {-70000, 0}, {0, 70000});
+  EXPECT_FALSE(flags.nsw);
+  EXPECT_FALSE(flags.nuw);
+
+  flags = wrap_flags(Op::Add, {}, {1, 1});
+  EXPECT_FALSE(flags.nsw);
+  EXPECT_FALSE(flags.nuw);
+
+  flags = wrap_flags(Op::Div, {0, 10}, {1, 10});
+  EXPECT_FALSE(flags.nsw);
+  EXPECT_FALSE(flags.nuw);
+  EXPECT_FALSE(flags.exact);
+
+  EXPECT_TRUE(wrap_flags(Op::Div, {}, {1, 1}).exact);
+  EXPECT_TRUE(wrap_flags(Op::Div, {}, {-1, -1}).exact);
+  EXPECT_TRUE(wrap_flags(Op::Div, {12, 12}, {-4, -4}).exact);
+  EXPECT_FALSE(wrap_flags(Op::Div, {13, 13}, {4, 4}).exact);
+  EXPECT_FALSE(wrap_flags(Op::Div, {12, 13}, {4, 4}).exact);
+  EXPECT_FALSE(wrap_flags(Op::Div, {12, 12}, {0, 0}).exact);
+  EXPECT_FALSE(wrap_flags(Op::Mod, {}, {1, 1}).exact);
+  EXPECT_FALSE(wrap_flags(Op::Mul, {4, 4}, {2, 2}).exact);
+}
+
+TEST(AnalysisTest, CountingLoop) {
+  auto module = parse_annotated(R"(module m
+def f(n: int): int {
+  let i: int
+  let s: int
+  while i < 100 {
+    s = s + i * n
+    i = i + 1
+  }
+  return i
+})");
+  auto facts = analyze_ranges(module);
+
+  const auto &stmts = body_stmts(module, 0);
+  const auto &loop = std::get<std::unique_ptr<WhileStmtNode>>(stmts[2]);
+  const auto &loop_stmts = compound_stmts(loop->body);
+  const auto &sum = std::get<AssignmentStmtNode>(loop_stmts[0]).assign_expr;
+  const auto &increment =
+      std::get<AssignmentStmtNode>(loop_stmts[1]).assign_expr;
+  const auto &counter =
+      std::get<std::unique_ptr<BinaryExprNode>>(increment)->lhs;
+  const auto &result = std::get<ReturnStmtNode>(stmts[3]).return_expr;
+
+  EXPECT_EQ(facts.range(expr_key(counter)), (Interval{0, 99}));
+  EXPECT_EQ(facts.range(expr_key(increment)), (Interval{1, 100}));
+  EXPECT_EQ(facts.range(expr_key(result)), (Interval{100, 100}));
+  EXPECT_TRUE(facts.range(expr_key(sum)).is_full());
+
+  auto flat_module = flatten(module);
+  annotate_module(flat_module, 1);
+  auto flat_facts = analyze_ranges(flat_module);
+  for (const auto &assignment : flat_module.assignments) {
+    auto range = flat_facts.flat_range(root(assignment.assign_expr));
+    if (assignment.var_name == "i")
+      EXPECT_EQ(range, (Interval{1, 100}));
+    else
+      EXPECT_TRUE(range.is_full());
+  }
+  EXPECT_EQ(flat_facts.flat_range(root(flat_module.returns[0].return_expr)),
+            (Interval{100, 100}));
+}
+
+TEST(AnalysisTest, BranchRefinement) {
+  auto module = parse_annotated(R"(module m
+def f(x: int, y: int): int {
+  if x > 0 {
+    if !(x >= 10) {
+      return x * x
+    }
+  }
+  if 5 <= y {
+    return y
+  }
+  return -x
+})");
+  auto facts = analyze_ranges(module);
+
+  const auto &stmts = body_stmts(module, 0);
+  const auto &outer = std::get<std::unique_ptr<IfStmtNode>>(stmts[0]);
+  const auto &inner = std::get<std::unique_ptr<IfStmtNode>>(
+      compound_stmts(outer->then_stmt)[0]);
+  const auto &square =
+      std::get<ReturnStmtNode>(compound_stmts(inner->then_stmt)[0])
+          .return_expr;
+  const auto &bounded = std::get<std::unique_ptr<IfStmtNode>>(stmts[1]);
+  const auto &y = std::get<ReturnStmtNode>(
+                      compound_stmts(bounded->then_stmt)[0])
+                      .return_expr;
+  const auto &negated = std::get<ReturnStmtNode>(stmts[2]).return_expr;
+
+  EXPECT_EQ(facts.range(expr_key(square)), (Interval{1, 81}));
+  EXPECT_EQ(facts.range(expr_key(y)), (Interval{5, 2147483647}));
+  EXPECT_TRUE(facts.range(expr_key(negated)).is_full());
+
+  auto flat_module = flatten(module);
+  annotate_module(flat_module, 1);
+  auto flat_facts = analyze_ranges(flat_module);
+  ASSERT_EQ(flat_module.returns.size(), 3u);
+  EXPECT_EQ(flat_facts.flat_range(root(flat_module.returns[0].return_expr)),
+            (Interval{1, 81}));
+  EXPECT_EQ(flat_facts.flat_range(root(flat_module.returns[1].return_expr)),
+            (Interval{5, 2147483647}));
+  EXPECT_TRUE(
+      flat_facts.flat_range(root(flat_module.returns[2].return_expr))
+          .is_full());
+}
+
+TEST(AnalysisTest, LoopExits) {
+  auto module = parse_annotated(R"(module m
+def f(n: int): int {
+  let i: int
+  while true {
+    if i == 10 {
+      break
+    }
+    i = i + 2
+    if i % 3 == 0 {
+      continue
+    }
+  }
+  return i % 4
+})");
+  auto facts = analyze_ranges(module);
+
+  const auto &stmts = body_stmts(module, 0);
+  const auto &result = std::get<ReturnStmtNode>(stmts[2]).return_expr;
+  EXPECT_EQ(facts.range(expr_key(result)), (Interval{0, 3}));
+
+  auto flat_module = flatten(module);
+  annotate_module(flat_module, 1);
+  auto flat_facts = analyze_ranges(flat_module);
+  EXPECT_EQ(flat_facts.flat_range(root(flat_module.returns[0].return_expr)),
+            (Interval{0, 3}));
+}
+
+TEST(AnalysisTest, Effects) {
+  auto module = parse_annotated(R"(module m
+extern ext(x: int): int
+def fib(n: int): int {
+  if n <= 1 {
+    return n
+  } else {
+    return fib(n - 1) + fib(n - 2)
+  }
+}
+def even(n: int): bool {
+  if n == 0 {
+    return true
+  }
+  return odd(n - 1)
+}
+def odd(n: int): bool {
+  if n == 0 {
+    return false
+  }
+  return even(n - 1)
+}
+def sq(x: int): int {
+  return x * x
+}
+def countdown(n: int): int {
+  while n > 0 {
+    n = n - 1
+  }
+  return sq(n)
+}
+def io(x: int): int {
+  return ext(sq(x))
+})");
+  auto facts = analyze_effects(module);
+
+  const auto *ext = facts.find("ext");
+  ASSERT_NE(ext, nullptr);
+  EXPECT_EQ(ext->purity, Purity::Effectful);
+  EXPECT_TRUE(ext->is_extern);
+  EXPECT_FALSE(ext->no_unwind);
+
+  const auto *fib = facts.find("fib");
+  ASSERT_NE(fib, nullptr);
+  EXPECT_EQ(fib->purity, Purity::Pure);
+  EXPECT_TRUE(fib->recursive);
+  EXPECT_FALSE(fib->no_recurse);
+  EXPECT_TRUE(fib->no_unwind);
+  EXPECT_FALSE(fib->will_return);
+
+  EXPECT_TRUE(facts.find("even")->recursive);
+  EXPECT_TRUE(facts.find("odd")->recursive);
+
+  const auto *countdown = facts.find("countdown");
+  ASSERT_NE(countdown, nullptr);
+  EXPECT_EQ(countdown->purity, Purity::Pure);
+  EXPECT_TRUE(countdown->no_recurse);
+  EXPECT_FALSE(countdown->will_return);
+
+  const auto *io = facts.find("io");
+  ASSERT_NE(io, nullptr);
+  EXPECT_EQ(io->purity, Purity::Effectful);
+  EXPECT_FALSE(io->no_recurse);
+  EXPECT_FALSE(io->no_unwind);
+  EXPECT_EQ(facts.find("missing"), nullptr);
+
+  auto report = effects_report(facts);
+  EXPECT_EQ(report, "ext: effectful, extern\n"
+                    "fib: pure, recursive, nounwind\n"
+                    "even: pure, recursive, nounwind\n"
+                    "odd: pure, recursive, nounwind\n"
+                    "sq: pure, norecurse, nounwind, willreturn\n"
+                    "countdown: pure, norecurse, nounwind\n"
+                    "io: effectful\n");
+
+  auto flat_module = flatten(module);
+  EXPECT_EQ(effects_report(analyze_effects(flat_module)), report);
+}
+
+TEST(AnalysisTest, DivisionTraps) {
+  EXPECT_TRUE(division_may_trap({}, {}));
+  EXPECT_TRUE(division_may_trap({0, 10}, {-1, 1}));
+  EXPECT_FALSE(division_may_trap({0, 10}, {-1, -1}));
+  EXPECT_TRUE(division_may_trap({}, {-1, -1}));
+  EXPECT_FALSE(division_may_trap({}, {2, 2}));
+
+  auto module = parse_annotated(R"(module m
+def bucket(x: int, n: int): int {
+  return x / n
+}
+def half(x: int): int {
+  return x / 2 + x % 7
+}
+def safe(x: int): int {
+  if x > 0 {
+    return 1000 / x
+  }
+  return 0
+}
+def caller(x: int): int {
+  return bucket(x, 3)
+})");
+  auto ranges = analyze_ranges(module);
+  auto facts = analyze_effects(module, true, &ranges);
+  EXPECT_TRUE(facts.find("bucket")->may_trap);
+  EXPECT_FALSE(facts.find("bucket")->will_return);
+  EXPECT_FALSE(facts.find("half")->may_trap);
+  EXPECT_FALSE(facts.find("safe")->may_trap);
+  EXPECT_TRUE(facts.find("safe")->will_return);
+  EXPECT_TRUE(facts.find("caller")->may_trap);
+
+  auto unranged = analyze_effects(module, true);
+  EXPECT_TRUE(unranged.find("half")->may_trap);
+  auto unchecked = analyze_effects(module);
+  EXPECT_FALSE(unchecked.find("bucket")->may_trap);
+  EXPECT_TRUE(unchecked.find("bucket")->will_return);
+
+  auto flat_module = flatten(module);
+  annotate_module(flat_module, 1);
+  auto flat_ranges = analyze_ranges(flat_module);
+  EXPECT_EQ(effects_report(analyze_effects(flat_module, true, &flat_ranges)),
+            effects_report(facts));
+}
@@ -1,19 +1,39 @@
 #include <gtest/gtest.h>
 
+#include <algorithm>
 #include <memory>
+#include <optional>
 #include <stdexcept>
+#include <string>
 #include <utility>
 #include <variant>
 #include <vector>
 
 #include "annotator.h"
 #include "ast.h"
+#include "flat_ast.h"
+#include "overload.h"
+#include "types.h"
 #include "util.h"
 
 using namespace stapl::ast;
 using namespace stapl::types;
 using namespace stapl::util;
 
+TEST(TypeCheckerTest, TypeTable) {
+  EXPECT_EQ(TypeId("int"), int_type);
+  EXPECT_EQ(TypeId("bool").kind(), TypeKind::Bool);
+  EXPECT_EQ(void_type.str(), "void");
+  EXPECT_EQ(TypeId().kind(), TypeKind::None);
+
+  TypeId named("vec3");
+  EXPECT_EQ(named, TypeId(std::string("vec3")));
+  EXPECT_NE(named, float_type);
+  EXPECT_EQ(named.kind(), TypeKind::Named);
+  EXPECT_EQ(named.str(), "vec3");
+  EXPECT_EQ(TypeId::from_id(named.id()), named);
+}
+
 TEST(TypeCheckerTest, Literals) {
   ExprNode literal_int = LiteralExprNode<int>(42),
            literal_float = LiteralExprNode<double>(3.14);
@@ -37,18 +57,55 @@ TEST(TypeCheckerTest, Variables) {
   EXPECT_THROW(std::visit(a, var_y_expr), std::logic_error);
 }
 
+TEST(TypeCheckerTest, BlockScopes) {
+  // `x` is an int in the function, a float in the then branch and out of
+  // scope after the inner block.
+  auto inner_stmts = make_vector<StmtNode>(
+      LetStmtNode("x", "float"), LetStmtNode("y", "int"),
+      AssignmentStmtNode("x", LiteralExprNode<double>(1.5)));
+  auto func_body = make_vector<StmtNode>(
+      LetStmtNode("x", "int"),
+      std::make_unique<IfStmtNode>(
+          LiteralExprNode<bool>(true),
+          std::make_unique<CompoundStmtNode>(std::move(inner_stmts)),
+          std::make_unique<CompoundStmtNode>(std::vector<StmtNode>())),
+      AssignmentStmtNode("x", LiteralExprNode<int>(1)),
+      ReturnStmtNode(VariableExprNode("x")));
+  DeclNode func_decl = FunctionDeclNode(
+      PrototypeNode("f", {}, "int"),
+      std::make_unique<CompoundStmtNode>(std::move(func_body)));
+  TypeAnnotator a;
+  std::visit(a, func_decl);
+
+  auto leaking_body = make_vector<StmtNode>(
+      std::make_unique<CompoundStmtNode>(
+          make_vector<StmtNode>(LetStmtNode("y", "int"))),
+      ReturnStmtNode(VariableExprNode("y")));
+  DeclNode leaking_decl = FunctionDeclNode(
+      PrototypeNode("g", {}, "int"),
+      std::make_unique<CompoundStmtNode>(std::move(leaking_body)));
+  EXPECT_THROW(std::visit(a, leaking_decl), std::logic_error);
+
+  auto redefining_body = make_vector<StmtNode>(LetStmtNode("x", "int"),
+                                               LetStmtNode("x", "float"));
+  DeclNode redefining_decl = FunctionDeclNode(
+      PrototypeNode("h", {{"x", "int"}}, "int"),
+      std::make_unique<CompoundStmtNode>(std::move(redefining_body)));
+  EXPECT_THROW(std::visit(a, redefining_decl), std::logic_error);
+}
+
 TEST(TypeCheckerTest, UnaryExpr) {
   auto let_stmts =
       make_vector<StmtNode>(LetStmtNode("x", "int"), LetStmtNode("y", "int"));
-  StmtNode block_stmt =
-      std::make_unique<CompoundStmtNode>(std::move(let_stmts));
   ExprNode expr = std::make_unique<UnaryExprNode>(
-      "!",
+      Op::Not,
       std::make_unique<BinaryExprNode>(
-          "==", std::make_unique<UnaryExprNode>("-", VariableExprNode("x")),
-          std::make_unique<UnaryExprNode>("+", VariableExprNode("y"))));
+          Op::Eq,
+          std::make_unique<UnaryExprNode>(Op::Sub, VariableExprNode("x")),
+          std::make_unique<UnaryExprNode>(Op::Add, VariableExprNode("y"))));
   TypeAnnotator a;
-  std::visit(a, block_stmt);
+  for (auto &let_stmt : let_stmts)
+    std::visit(a, let_stmt);
   EXPECT_EQ(std::visit(a, expr), "bool");
   EXPECT_EQ(std::get<std::unique_ptr<UnaryExprNode>>(expr)->expr_type.value(),
             "bool");
@@ -68,22 +125,25 @@ TEST(TypeCheckerTest, UnaryExpr) {
                     ->rhs)
                 ->expr_type.value(),
             "int");
+
+  ExprNode bad_expr =
+      std::make_unique<UnaryExprNode>(Op::Not, VariableExprNode("x"));
+  EXPECT_THROW(std::visit(a, bad_expr), std::logic_error);
 }
 
 TEST(TypeCheckerTest, BinaryExpr) {
   auto let_stmts =
       make_vector<StmtNode>(LetStmtNode("x", "int"), LetStmtNode("y", "int"),
                             LetStmtNode("z", "int"));
-  StmtNode block_stmt =
-      std::make_unique<CompoundStmtNode>(std::move(let_stmts));
   ExprNode expr = std::make_unique<BinaryExprNode>(
-      "+",
-      std::make_unique<BinaryExprNode>("*", LiteralExprNode<int>(42),
+      Op::Add,
+      std::make_unique<BinaryExprNode>(Op::Mul, LiteralExprNode<int>(42),
                                        VariableExprNode("x")),
-      std::make_unique<BinaryExprNode>("/", VariableExprNode("y"),
+      std::make_unique<BinaryExprNode>(Op::Div, VariableExprNode("y"),
                                        VariableExprNode("z")));
   TypeAnnotator a;
-  std::visit(a, block_stmt);
+  for (auto &let_stmt : let_stmts)
+    std::visit(a, let_stmt);
   EXPECT_EQ(std::visit(a, expr), "int");
   EXPECT_EQ(std::get<std::unique_ptr<BinaryExprNode>>(expr)->expr_type.value(),
             "int");
@@ -100,8 +160,8 @@ TEST(TypeCheckerTest, BinaryExpr) {
 TEST(TypeCheckerTest, CallExpr) {
   auto func_body =
       make_vector<StmtNode>(ReturnStmtNode(std::make_unique<BinaryExprNode>(
-          "+", VariableExprNode("x"),
-          std::make_unique<BinaryExprNode>("+", VariableExprNode("y"),
+          Op::Add, VariableExprNode("x"),
+          std::make_unique<BinaryExprNode>(Op::Add, VariableExprNode("y"),
                                            VariableExprNode("z")))));
   DeclNode func_decl = FunctionDeclNode(
       PrototypeNode("add", {{"x", "int"}, {"y", "int"}, {"z", "int"}}, "int"),
@@ -110,22 +170,51 @@ TEST(TypeCheckerTest, CallExpr) {
       make_vector<ExprNode>(LiteralExprNode<int>(1), LiteralExprNode<int>(2),
                             LiteralExprNode<int>(3));
   ExprNode call_expr = std::make_unique<CallExprNode>("add", std::move(args));
+  auto nested_args = make_vector<ExprNode>(
+      LiteralExprNode<int>(4), std::move(call_expr), LiteralExprNode<int>(5));
+  ExprNode nested_call_expr =
+      std::make_unique<CallExprNode>("add", std::move(nested_args));
+  ExprNode bad_call_expr = std::make_unique<CallExprNode>(
+      "add", make_vector<ExprNode>(LiteralExprNode<int>(1)));
   TypeAnnotator a;
   std::visit(a, func_decl);
-  EXPECT_EQ(std::visit(a, call_expr), "int");
+  EXPECT_EQ(std::visit(a, nested_call_expr), "int");
+  EXPECT_THROW(std::visit(a, bad_call_expr), std::logic_error);
+}
+
+TEST(TypeCheckerTest, Overloads) {
+  OverloadTable table;
+  std::vector<TypeId> int_args = {int_type, int_type},
+                      float_args = {float_type, float_type};
+  table.add("max", int_args, int_type);
+  table.add("max", float_args, float_type);
+  table.add("max", {}, void_type);
+  EXPECT_EQ(table.find("max", int_args), int_type);
+  EXPECT_EQ(table.find("max", float_args), float_type);
+  EXPECT_EQ(table.find("max", {}), void_type);
+  EXPECT_EQ(table.find("max", std::vector<TypeId>{int_type}), std::nullopt);
+  EXPECT_EQ(table.find("min", int_args), std::nullopt);
+  EXPECT_THROW(table.add("max", int_args, int_type), std::logic_error);
+  EXPECT_THROW(table.add("max", float_args, bool_type), std::logic_error);
+
+  for (int i = 0; i < 100; i++)
+    table.add("f" + std::to_string(i), int_args, bool_type);
+  EXPECT_EQ(table.size(), 103);
+  EXPECT_EQ(table.find("f42", int_args), bool_type);
+  EXPECT_EQ(table.find("max", float_args), float_type);
 }
 
 TEST(TypeCheckerTest, FunctionScope) {
   auto func_body_f = make_vector<StmtNode>(
       LetStmtNode("x", "int"), LetStmtNode("y", "int"),
       AssignmentStmtNode(
-          "x", std::make_unique<BinaryExprNode>("+", VariableExprNode("a"),
+          "x", std::make_unique<BinaryExprNode>(Op::Add, VariableExprNode("a"),
                                                 VariableExprNode("b"))),
       AssignmentStmtNode(
-          "y", std::make_unique<BinaryExprNode>("+", VariableExprNode("a"),
+          "y", std::make_unique<BinaryExprNode>(Op::Add, VariableExprNode("a"),
                                                 VariableExprNode("b"))),
       ReturnStmtNode(std::make_unique<BinaryExprNode>(
-          "*", VariableExprNode("x"), VariableExprNode("y"))));
+          Op::Mul, VariableExprNode("x"), VariableExprNode("y"))));
   DeclNode func_decl_f = FunctionDeclNode(
       PrototypeNode("f", {{"a", "int"}, {"b", "int"}}, "int"),
       std::make_unique<CompoundStmtNode>(std::move(func_body_f)));
@@ -140,3 +229,109 @@ TEST(TypeCheckerTest, FunctionScope) {
   std::visit(a, func_decl_f);
   EXPECT_THROW(std::visit(a, func_decl_g), std::logic_error);
 }
+
+TEST(TypeCheckerTest, FlatModule) {
+  auto func_body = make_vector<StmtNode>(
+      LetStmtNode("y", "float"),
+      AssignmentStmtNode(
+          "y", std::make_unique<CallExprNode>(
+                   "g", make_vector<ExprNode>(
+                            VariableExprNode("x"),
+                            std::make_unique<UnaryExprNode>(
+                                Op::Sub, LiteralExprNode<double>(1.5))))),
+      ReturnStmtNode(std::make_unique<BinaryExprNode>(
+          Op::Lt, VariableExprNode("x"), LiteralExprNode<int>(3))));
+  auto decls = make_vector<DeclNode>(
+      FunctionDeclNode(
+          PrototypeNode("g", {{"a", "int"}, {"b", "float"}}, "float")),
+      FunctionDeclNode(
+          PrototypeNode("f", {{"x", "int"}}, "bool"),
+          std::make_unique<CompoundStmtNode>(std::move(func_body))));
+  auto flat = flatten(Module("test", std::move(decls)));
+  TypeAnnotator a;
+  a(flat);
+  std::vector<TypeId> types = {"int", "float", "float", "float",
+                               "int", "int",   "bool"};
+  EXPECT_EQ(flat.exprs.types, types);
+
+  auto bad_body = make_vector<StmtNode>(ReturnStmtNode(
+      std::make_unique<BinaryExprNode>(Op::Add, LiteralExprNode<int>(1),
+                                       LiteralExprNode<bool>(true))));
+  auto bad_decls = make_vector<DeclNode>(FunctionDeclNode(
+      PrototypeNode("h", {}, "int"),
+      std::make_unique<CompoundStmtNode>(std::move(bad_body))));
+  auto bad_flat = flatten(Module("bad", std::move(bad_decls)));
+  EXPECT_THROW(a(bad_flat), std::logic_error);
+}
+
+namespace {
+Module make_chain_module(int func_count, int bad_func_begin) {
+  // Function i returns the result of calling function i + 1, which is declared
+  // later, and functions from `bad_func_begin` call undeclared functions.
+  std::vector<DeclNode> decls;
+  for (int i = 0; i < func_count; i++) {
+    ExprNode return_expr = LiteralExprNode<int>(i);
+    if (i >= bad_func_begin)
+      return_expr = std::make_unique<CallExprNode>(
+          "g" + std::to_string(i),
+          make_vector<ExprNode>(VariableExprNode("x")));
+    else if (i + 1 < func_count)
+      return_expr = std::make_unique<CallExprNode>(
+          "f" + std::to_string(i + 1),
+          make_vector<ExprNode>(VariableExprNode("x")));
+    auto func_body = make_vector<StmtNode>(
+        LetStmtNode("y", "int"),
+        AssignmentStmtNode("y", std::move(return_expr)),
+        ReturnStmtNode(VariableExprNode("y")));
+    decls.push_back(FunctionDeclNode(
+        PrototypeNode("f" + std::to_string(i), {{"x", "int"}}, "int"),
+        std::make_unique<CompoundStmtNode>(std::move(func_body))));
+  }
+  return Module("chain", std::move(decls));
+}
+} // namespace
+
+TEST(TypeCheckerTest, AnnotateModule) {
+  for (unsigned jobs = 1; jobs <= 4; jobs++) {
+    auto module = make_chain_module(50, 50);
+    auto flat = flatten(module);
+    annotate_module(module, jobs);
+    auto &body = std::get<std::unique_ptr<CompoundStmtNode>>(
+        std::get<FunctionDeclNode>(module.decls[0]).func_body.value());
+    auto &assign = std::get<AssignmentStmtNode>(body->stmts[1]);
+    EXPECT_EQ(std::get<std::unique_ptr<CallExprNode>>(assign.assign_expr)
+                  ->expr_type.value(),
+              int_type);
+
+    annotate_module(flat, jobs);
+    EXPECT_EQ(std::count(flat.exprs.types.begin(), flat.exprs.types.end(),
+                         int_type),
+              flat.exprs.size());
+  }
+
+  auto duplicate = make_chain_module(2, 2);
+  duplicate.decls.push_back(FunctionDeclNode(
+      PrototypeNode("f0", {{"y", "int"}}, "int"),
+      std::make_unique<CompoundStmtNode>(std::vector<StmtNode>())));
+  EXPECT_THROW(annotate_module(duplicate, 2), std::logic_error);
+}
+
+TEST(TypeCheckerTest, AnnotateModuleErrors) {
+  // Function 20 is the first to fail, whatever the number of threads.
+  for (unsigned jobs = 1; jobs <= 8; jobs++) {
+    auto module = make_chain_module(60, 20);
+    auto flat = flatten(module);
+    try {
+      annotate_module(module, jobs);
+      ADD_FAILURE() << "expected a type error";
+    } catch (const std::logic_error &error) {
+      EXPECT_STREQ(error.what(), "no matching signature of g20");
+    }
+    try {
+      annotate_module(flat, jobs);
+      ADD_FAILURE() << "expected a type error";
+    } catch (const std::logic_error &error) {
+      EXPECT_STREQ(error.what(), "no matching signature of g20");
+    }
+  }
+}
@@ -0,0 +1,36 @@
+#include "arena.h"
+
+#include <cstdint>
+
+#include <gtest/gtest.h>
+
+using namespace stapl::util;
+
+TEST(ArenaTest, Allocate) {
+  Arena arena(256);
+  auto *small = static_cast<char *>(arena.allocate(3, 1));
+  auto *aligned = arena.allocate(8, 8);
+  EXPECT_EQ(reinterpret_cast<std::uintptr_t>(aligned) % 8, 0u);
+  EXPECT_GE(static_cast<char *>(aligned), small + 3);
+  arena.allocate(1000, 16);
+  EXPECT_EQ(arena.bytes_reserved(), 256u + 1000u);
+  for (int i = 0; i < 100; i++)
+    arena.allocate(16, 16);
+  EXPECT_GE(arena.bytes_used(), 3u + 8u + 1000u + 1600u);
+  EXPECT_LE(arena.bytes_used(), arena.bytes_reserved());
+}
+
+TEST(ArenaTest, Scope) {
+  Arena outer, inner;
+  EXPECT_EQ(Arena::current(), nullptr);
+  {
+    Arena::Scope outer_scope(&outer);
+    EXPECT_EQ(Arena::current(), &outer);
+    {
+      Arena::Scope inner_scope(&inner);
+      EXPECT_EQ(Arena::current(), &inner);
+    }
+    EXPECT_EQ(Arena::current(), &outer);
+  }
+  EXPECT_EQ(Arena::current(), nullptr);
+}
@@ -0,0 +1,196 @@
+#include "ast.h"
+#include "irgen.h"
+#include "jit.h"
+#include "test_util.h"
+
+#include <filesystem>
+#include <map>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <sys/stat.h>
+
+#include <gtest/gtest.h>
+
+using namespace stapl::jit;
+using stapl::ir::IRGen;
+using stapl::opt::OptLevel;
+using stapl::test_util::parse_annotated;
+
+namespace {
+constexpr std::string_view source = R"(module test
+def add(x: int, y: int): int {
+  return x + y
+}
+def scale(x: float, y: float): float {
+  return x * y + 0.5
+}
+def at_most(x: int, y: int): bool {
+  return x <= y
+}
+def negate(x: bool): bool {
+  return !x
+}
+def nothing(x: int): void {
+  x = x + 1
+}
+)";
+
+constexpr std::string_view chain_source = R"(module chain
+def square(x: int): int {
+  return x * x
+}
+def sum_squares(n: int): int {
+  let s: int
+  s = 0
+  while n > 0 {
+    s = s + square(n)
+    n = n - 1
+  }
+  return s
+}
+def main(n: int): int {
+  return sum_squares(n) + square(2)
+}
+)";
+
+void add_source(JIT &jit, std::string_view code = source) {
+  auto module = parse_annotated(code);
+  IRGen irgen;
+  irgen.codegen(module);
+  auto [context, llvm_module] = irgen.release_module();
+  jit.add_module(std::move(context), std::move(llvm_module));
+}
+
+// Map the objects in a cache directory to their inodes, which change when an
+// object is written again rather than loaded.
+std::map<std::string, ino_t> cached_objects(const std::filesystem::path &dir) {
+  std::map<std::string, ino_t> objects;
+  for (const auto &entry : std::filesystem::directory_iterator(dir)) {
+    struct stat info;
+    if (entry.path().extension() == ".o" &&
+        stat(entry.path().c_str(), &info) == 0)
+      objects[entry.path().filename().string()] = info.st_ino;
+  }
+  return objects;
+}
+
+std::optional<std::string> run(const std::string &entry,
+                               const std::vector<std::string> &args,
+                               JITOptions options = {}) {
+  options.entry = entry;
+  JIT jit(options);
+  add_source(jit);
+  return jit.run(args);
+}
+} // namespace
+
+TEST(JITTest, Int) {
+  EXPECT_EQ(run("add", {"40", "2"}), "42");
+  EXPECT_EQ(run("add", {"-7", "3"}), "-4");
+}
+
+TEST(JITTest, Float) { EXPECT_EQ(run("scale", {"1.5", "3"}), "5"); }
+
+TEST(JITTest, Bool) {
+  EXPECT_EQ(run("at_most", {"5", "10"}), "true");
+  EXPECT_EQ(run("at_most", {"11", "10"}), "false");
+  EXPECT_EQ(run("negate", {"false"}), "true");
+}
+
+TEST(JITTest, Void) { EXPECT_EQ(run("nothing", {"1"}), std::nullopt); }
+
+TEST(JITTest, Optimized) {
+  JITOptions options;
+  options.opt_level = OptLevel::O2;
+  EXPECT_EQ(run("add", {"40", "2"}, options), "42");
+  options.lazy = true;
+  EXPECT_EQ(run("at_most", {"5", "10"}, options), "true");
+}
+
+TEST(JITTest, ArgCountMismatch) {
+  JITOptions options;
+  options.entry = "add";
+  JIT jit(options);
+  add_source(jit);
+  EXPECT_THROW(jit.run({"1"}), std::logic_error);
+  EXPECT_THROW(jit.run({"1", "2", "3"}), std::logic_error);
+  EXPECT_EQ(jit.run({"1", "2"}), "3");
+}
+
+TEST(JITTest, InvalidArgument) {
+  EXPECT_THROW(run("add", {"1", "two"}), std::logic_error);
+  EXPECT_THROW(run("add", {"1", "1.5"}), std::logic_error);
+  EXPECT_THROW(run("add", {"1", "99999999999"}), std::logic_error);
+  EXPECT_THROW(run("scale", {"1.5", "x"}), std::logic_error);
+  EXPECT_THROW(run("negate", {"1"}), std::logic_error);
+}
+
+TEST(JITTest, UnknownEntry) {
+  JITOptions options;
+  options.entry = "missing";
+  JIT jit(options);
+  EXPECT_THROW(add_source(jit), std::logic_error);
+}
+
+TEST(JITTest, LazyCallChain) {
+  JITOptions options;
+  options.lazy = true;
+  JIT jit(options);
+  add_source(jit, chain_source);
+  EXPECT_EQ(jit.run({"4"}), "34");
+  EXPECT_EQ(jit.run({"0"}), "4");
+}
+
+TEST(JITTest, Speculate) {
+  JITOptions options;
+  options.lazy = true;
+  options.speculate = true;
+  options.opt_level = OptLevel::O2;
+  JIT jit(options);
+  add_source(jit, chain_source);
+  EXPECT_EQ(jit.run({"4"}), "34");
+  EXPECT_EQ(jit.run({"10"}), "389");
+}
+
+TEST(JITTest, CompileThreads) {
+  for (bool lazy : {false, true}) {
+    JITOptions options;
+    options.lazy = lazy;
+    options.compile_threads = 2;
+    options.opt_level = OptLevel::O2;
+    JIT jit(options);
+    add_source(jit, chain_source);
+    EXPECT_EQ(jit.run({"4"}), "34");
+    EXPECT_EQ(jit.run({"3"}), "18");
+  }
+}
+
+TEST(JITTest, Cache) {
+  auto dir = std::filesystem::temp_directory_path() / "stapl_jit_test_cache";
+  for (unsigned threads : {0u, 2u}) {
+    std::filesystem::remove_all(dir);
+    JITOptions options;
+    options.opt_level = OptLevel::O2;
+    options.compile_threads = threads;
+    options.cache_dir = dir.string();
+    {
+      JIT jit(options);
+      add_source(jit, chain_source);
+      EXPECT_EQ(jit.run({"4"}), "34");
+    }
+    auto objects = cached_objects(dir);
+    EXPECT_FALSE(objects.empty());
+    {
+      JIT jit(options);
+      add_source(jit, chain_source);
+      EXPECT_EQ(jit.run({"4"}), "34");
+    }
+    EXPECT_EQ(cached_objects(dir), objects);
+  }
+  std::filesystem::remove_all(dir);
+}
@@ -1,12 +1,20 @@
 #include <gtest/gtest.h>
 
 #include "lexer.h"
+#include "scan.h"
+#include "token_buffer.h"
 
+#include <cctype>
+#include <cstdint>
 #include <sstream>
+#include <stdexcept>
 #include <string>
+#include <string_view>
 #include <utility>
+#include <vector>
 
 using namespace stapl::parsing;
+using stapl::ast::Op;
 
 TEST(LexerTest, Def) {
   Lexer lexer("def");
@@ -18,21 +26,21 @@ TEST(LexerTest, ArraySubscript) {
   Lexer lexer("arr[0][1][2]");
   EXPECT_EQ(lexer.get_token(), Token(TokenKind::Identifier, "arr"));
   EXPECT_EQ(lexer.get_token(), Token(TokenKind::Misc, "["));
-  EXPECT_EQ(lexer.get_token(), Token(TokenKind::Int, "0"));
+  EXPECT_EQ(lexer.get_token(), Token(TokenKind::Int, "0", 0));
   EXPECT_EQ(lexer.get_token(), Token(TokenKind::Misc, "]"));
   EXPECT_EQ(lexer.get_token(), Token(TokenKind::Misc, "["));
-  EXPECT_EQ(lexer.get_token(), Token(TokenKind::Int, "1"));
+  EXPECT_EQ(lexer.get_token(), Token(TokenKind::Int, "1", 1));
   EXPECT_EQ(lexer.get_token(), Token(TokenKind::Misc, "]"));
   EXPECT_EQ(lexer.get_token(), Token(TokenKind::Misc, "["));
-  EXPECT_EQ(lexer.get_token(), Token(TokenKind::Int, "2"));
+  EXPECT_EQ(lexer.get_token(), Token(TokenKind::Int, "2", 2));
   EXPECT_EQ(lexer.get_token(), Token(TokenKind::Misc, "]"));
   EXPECT_EQ(lexer.get_token(), Token(TokenKind::Eof, ""));
 }
 
 TEST(LexerTest, Literals) {
   Lexer lexer("42 3.141592 true false");
-  EXPECT_EQ(lexer.get_token(), Token(TokenKind::Int, "42"));
-  EXPECT_EQ(lexer.get_token(), Token(TokenKind::Float, "3.141592"));
+  EXPECT_EQ(lexer.get_token(), Token(TokenKind::Int, "42", 42));
+  EXPECT_EQ(lexer.get_token(), Token(TokenKind::Float, "3.141592", 3.141592));
   EXPECT_EQ(lexer.get_token(), Token(TokenKind::Bool, "true"));
   EXPECT_EQ(lexer.get_token(), Token(TokenKind::Bool, "false"));
   EXPECT_EQ(lexer.get_token(), Token(TokenKind::Eof, ""));
@@ -44,7 +52,7 @@ TEST(LexerTest, FunctionDef) {
   EXPECT_EQ(lexer.get_token(), Token(TokenKind::Identifier, "func"));
   EXPECT_EQ(lexer.get_token(), Token(TokenKind::Misc, "("));
   EXPECT_EQ(lexer.get_token(), Token(TokenKind::Misc, ")"));
-  EXPECT_EQ(lexer.get_token(), Token(TokenKind::Int, "0"));
+  EXPECT_EQ(lexer.get_token(), Token(TokenKind::Int, "0", 0));
   EXPECT_EQ(lexer.get_token(), Token(TokenKind::Eof, ""));
 }
 
@@ -64,15 +72,15 @@ TEST(LexerTest, Proto) {
 TEST(LexerTest, Operator) {
   Lexer lexer("(1 + 2 * 3 >= 0) != false");
   EXPECT_EQ(lexer.get_token(), Token(TokenKind::Misc, "("));
-  EXPECT_EQ(lexer.get_token(), Token(TokenKind::Int, "1"));
-  EXPECT_EQ(lexer.get_token(), Token(TokenKind::Op, "+"));
-  EXPECT_EQ(lexer.get_token(), Token(TokenKind::Int, "2"));
-  EXPECT_EQ(lexer.get_token(), Token(TokenKind::Op, "*"));
-  EXPECT_EQ(lexer.get_token(), Token(TokenKind::Int, "3"));
-  EXPECT_EQ(lexer.get_token(), Token(TokenKind::Op, ">="));
-  EXPECT_EQ(lexer.get_token(), Token(TokenKind::Int, "0"));
+  EXPECT_EQ(lexer.get_token(), Token(TokenKind::Int, "1", 1));
+  EXPECT_EQ(lexer.get_token(), Token(TokenKind::Op, "+", Op::Add));
+  EXPECT_EQ(lexer.get_token(), Token(TokenKind::Int, "2", 2));
+  EXPECT_EQ(lexer.get_token(), Token(TokenKind::Op, "*", Op::Mul));
+  EXPECT_EQ(lexer.get_token(), Token(TokenKind::Int, "3", 3));
+  EXPECT_EQ(lexer.get_token(), Token(TokenKind::Op, ">=", Op::Ge));
+  EXPECT_EQ(lexer.get_token(), Token(TokenKind::Int, "0", 0));
   EXPECT_EQ(lexer.get_token(), Token(TokenKind::Misc, ")"));
-  EXPECT_EQ(lexer.get_token(), Token(TokenKind::Op, "!="));
+  EXPECT_EQ(lexer.get_token(), Token(TokenKind::Op, "!=", Op::Ne));
   EXPECT_EQ(lexer.get_token(), Token(TokenKind::Bool, "false"));
   EXPECT_EQ(lexer.get_token(), Token(TokenKind::Eof, ""));
 }
@@ -81,8 +89,8 @@ TEST(LexerTest, If) {
   Lexer lexer("if x < 0");
   EXPECT_EQ(lexer.get_token(), Token(TokenKind::If, "if"));
   EXPECT_EQ(lexer.get_token(), Token(TokenKind::Identifier, "x"));
-  EXPECT_EQ(lexer.get_token(), Token(TokenKind::Op, "<"));
-  EXPECT_EQ(lexer.get_token(), Token(TokenKind::Int, "0"));
+  EXPECT_EQ(lexer.get_token(), Token(TokenKind::Op, "<", Op::Lt));
+  EXPECT_EQ(lexer.get_token(), Token(TokenKind::Int, "0", 0));
   EXPECT_EQ(lexer.get_token(), Token(TokenKind::Eof, ""));
 }
 
@@ -96,25 +104,25 @@ TEST(LexerTest, While) {
 })");
   EXPECT_EQ(lexer.get_token(), Token(TokenKind::While, "while"));
   EXPECT_EQ(lexer.get_token(), Token(TokenKind::Identifier, "x"));
-  EXPECT_EQ(lexer.get_token(), Token(TokenKind::Op, ">"));
-  EXPECT_EQ(lexer.get_token(), Token(TokenKind::Int, "0"));
+  EXPECT_EQ(lexer.get_token(), Token(TokenKind::Op, ">", Op::Gt));
+  EXPECT_EQ(lexer.get_token(), Token(TokenKind::Int, "0", 0));
   EXPECT_EQ(lexer.get_token(), Token(TokenKind::Misc, "{"));
   EXPECT_EQ(lexer.get_token(), Token(TokenKind::If, "if"));
   EXPECT_EQ(lexer.get_token(), Token(TokenKind::Identifier, "x"));
-  EXPECT_EQ(lexer.get_token(), Token(TokenKind::Op, "%"));
-  EXPECT_EQ(lexer.get_token(), Token(TokenKind::Int, "2"));
-  EXPECT_EQ(lexer.get_token(), Token(TokenKind::Op, "=="));
-  EXPECT_EQ(lexer.get_token(), Token(TokenKind::Int, "0"));
+  EXPECT_EQ(lexer.get_token(), Token(TokenKind::Op, "%", Op::Mod));
+  EXPECT_EQ(lexer.get_token(), Token(TokenKind::Int, "2", 2));
+  EXPECT_EQ(lexer.get_token(), Token(TokenKind::Op, "==", Op::Eq));
+  EXPECT_EQ(lexer.get_token(), Token(TokenKind::Int, "0", 0));
   EXPECT_EQ(lexer.get_token(), Token(TokenKind::Misc, "{"));
   EXPECT_EQ(lexer.get_token(), Token(TokenKind::Continue, "continue"));
   EXPECT_EQ(lexer.get_token(), Token(TokenKind::Misc, "}"));
   EXPECT_EQ(lexer.get_token(), Token(TokenKind::Else, "else"));
   EXPECT_EQ(lexer.get_token(), Token(TokenKind::If, "if"));
   EXPECT_EQ(lexer.get_token(), Token(TokenKind::Identifier, "x"));
-  EXPECT_EQ(lexer.get_token(), Token(TokenKind::Op, "%"));
-  EXPECT_EQ(lexer.get_token(), Token(TokenKind::Int, "3"));
-  EXPECT_EQ(lexer.get_token(), Token(TokenKind::Op, "=="));
-  EXPECT_EQ(lexer.get_token(), Token(TokenKind::Int, "2"));
+  EXPECT_EQ(lexer.get_token(), Token(TokenKind::Op, "%", Op::Mod));
+  EXPECT_EQ(lexer.get_token(), Token(TokenKind::Int, "3", 3));
+  EXPECT_EQ(lexer.get_token(), Token(TokenKind::Op, "==", Op::Eq));
+  EXPECT_EQ(lexer.get_token(), Token(TokenKind::Int, "2", 2));
   EXPECT_EQ(lexer.get_token(), Token(TokenKind::Misc, "{"));
   EXPECT_EQ(lexer.get_token(), Token(TokenKind::Break, "break"));
   EXPECT_EQ(lexer.get_token(), Token(TokenKind::Misc, "}"));
@@ -134,5 +142,231 @@ TEST(LexerTest, Let) {
 TEST(LexerTest, Return) {
   Lexer lexer("return 42");
   EXPECT_EQ(lexer.get_token(), Token(TokenKind::Return, "return"));
-  EXPECT_EQ(lexer.get_token(), Token(TokenKind::Int, "42"));
+  EXPECT_EQ(lexer.get_token(), Token(TokenKind::Int, "42", 42));
+}
+
+TEST(LexerTest, TokensViewIntoCode) {
+  std::string_view code = "let x: int";
+  Lexer lexer(code);
+  auto token = lexer.get_token();
+  EXPECT_EQ(token.text.data(), code.data());
+  token = lexer.get_token();
+  EXPECT_EQ(token.text.data(), code.data() + 4);
+}
+
+TEST(LexerTest, OperatorAtEof) {
+  Lexer lexer("x <=");
+  EXPECT_EQ(lexer.get_token(), Token(TokenKind::Identifier, "x"));
+  EXPECT_EQ(lexer.get_token(), Token(TokenKind::Op, "<=", Op::Le));
+  EXPECT_EQ(lexer.get_token(), Token(TokenKind::Eof, ""));
+}
+
+TEST(LexerTest, KeywordPrefixes) {
+  Lexer lexer("define iff elsewhere lets e m");
+  EXPECT_EQ(lexer.get_token(), Token(TokenKind::Identifier, "define"));
+  EXPECT_EQ(lexer.get_token(), Token(TokenKind::Identifier, "iff"));
+  EXPECT_EQ(lexer.get_token(), Token(TokenKind::Identifier, "elsewhere"));
+  EXPECT_EQ(lexer.get_token(), Token(TokenKind::Identifier, "lets"));
+  EXPECT_EQ(lexer.get_token(), Token(TokenKind::Identifier, "e"));
+  EXPECT_EQ(lexer.get_token(), Token(TokenKind::Identifier, "m"));
+  EXPECT_EQ(lexer.get_token(), Token(TokenKind::Eof, ""));
+}
+
+TEST(LexerTest, LongestOperator) {
+  Lexer lexer("a<==-b");
+  EXPECT_EQ(lexer.get_token(), Token(TokenKind::Identifier, "a"));
+  EXPECT_EQ(lexer.get_token(), Token(TokenKind::Op, "<=", Op::Le));
+  EXPECT_EQ(lexer.get_token(), Token(TokenKind::Op, "="));
+  EXPECT_EQ(lexer.get_token(), Token(TokenKind::Op, "-", Op::Sub));
+  EXPECT_EQ(lexer.get_token(), Token(TokenKind::Identifier, "b"));
+  EXPECT_EQ(lexer.get_token(), Token(TokenKind::Eof, ""));
+}
+
+TEST(LexerTest, LongRuns) {
+  std::string identifier =
+      "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ_0123456789";
+  std::string code = std::string(70, ' ') + "# " + std::string(50, '=') +
+                     "\n" + std::string(33, '\t') + identifier + " " +
+                     std::string(40, '1') + ".5";
+  Lexer lexer(code);
+  EXPECT_EQ(lexer.get_token(), Token(TokenKind::Identifier, identifier));
+  EXPECT_EQ(lexer.get_token(),
+            Token(TokenKind::Float, std::string(40, '1') + ".5",
+                  std::stod(std::string(40, '1') + ".5")));
+  EXPECT_EQ(lexer.get_token(), Token(TokenKind::Eof, ""));
+}
+
+TEST(LexerTest, ScanMatchesScalar) {
+  std::string code;
+  for (int c = 0; c < 256; c++)
+    code += static_cast<char>(c);
+  code += "   \t\t\n\r\v\f  abc_DEF_123 456.789 # comment\n x";
+  for (auto isa : {scan::Isa::SSE2, scan::Isa::AVX2}) {
+    if (!scan::isa_supported(isa))
+      continue;
+    for (std::size_t pos = 0; pos <= code.size(); pos++) {
+      EXPECT_EQ(scan::skip_whitespace(code, pos, isa),
+                scan::skip_whitespace(code, pos, scan::Isa::Scalar));
+      EXPECT_EQ(scan::skip_identifier(code, pos, isa),
+                scan::skip_identifier(code, pos, scan::Isa::Scalar));
+      EXPECT_EQ(scan::skip_number(code, pos, isa),
+                scan::skip_number(code, pos, scan::Isa::Scalar));
+      EXPECT_EQ(scan::find_line_end(code, pos, isa),
+                scan::find_line_end(code, pos, scan::Isa::Scalar));
+    }
+  }
+  for (int c = 0; c < 256; c++) {
+    std::string one(1, static_cast<char>(c));
+    EXPECT_EQ(scan::skip_whitespace(one, 0, scan::Isa::Scalar),
+              std::isspace(c) ? 1u : 0u);
+    EXPECT_EQ(scan::skip_identifier(one, 0, scan::Isa::Scalar),
+              std::isalnum(c) || c == '_' ? 1u : 0u);
+  }
+}
+
+TEST(LexerTest, NumberValues) {
+  Lexer lexer("9223372036854775807 .5 3.");
+  EXPECT_EQ(lexer.get_token(), Token(TokenKind::Int, "9223372036854775807",
+                                     INT64_C(9223372036854775807)));
+  EXPECT_EQ(lexer.get_token(), Token(TokenKind::Float, ".5", 0.5));
+  EXPECT_EQ(lexer.get_token(), Token(TokenKind::Float, "3.", 3.0));
+  EXPECT_EQ(lexer.get_token(), Token(TokenKind::Eof, ""));
+}
+
+TEST(LexerTest, BadNumbers) {
+  EXPECT_THROW(Lexer("9223372036854775808").get_token(), std::logic_error);
+  EXPECT_THROW(Lexer("1.2.3").get_token(), std::logic_error);
+  EXPECT_THROW(Lexer(".").get_token(), std::logic_error);
+}
+
+TEST(LexerTest, Streaming) {
+  std::string code = "module test\n"
+                     "# a comment that spans chunks\n"
+                     "def long_function_name(a: int): float {\n"
+                     "  let x: float\n"
+                     "  x = 123456.789 * 42 >= a != -1\n"
+                     "  return x\n"
+                     "}\n";
+  for (std::size_t chunk_size = 1; chunk_size <= 7; chunk_size++) {
+    Lexer expected_lexer(code);
+    std::istringstream input(code);
+    Lexer lexer(input, chunk_size);
+    while (true) {
+      auto expected = expected_lexer.get_token();
+      EXPECT_EQ(lexer.get_token(), expected);
+      if (expected.kind == TokenKind::Eof)
+        break;
+    }
+  }
+}
+
+TEST(LexerTest, Parallel) {
+  std::string code = "module test\n";
+  for (int i = 0; i < 50; i++) {
+    auto n = std::to_string(i);
+    code += "extern ext" + n + "(x: int): int\n" + "def f" + n +
+            "(x: int): int {\n" + "  # def inside a comment\n" +
+            "  return ext" + n + "(x) * " + n + " + 1.5\n" + "}\n";
+  }
+  code += "\n# trailing comment";
+  auto expected = tokenize(code);
+  EXPECT_EQ(expected.size(), 1453u);
+  EXPECT_EQ(expected.back().kind, TokenKind::Eof);
+  for (unsigned jobs = 1; jobs <= 8; jobs++)
+    EXPECT_EQ(tokenize_parallel(code, jobs), expected);
+
+  std::string truncated = code;
+  truncated[truncated.find("def f25")] = '\0';
+  EXPECT_EQ(tokenize_parallel(truncated, 4), tokenize(truncated));
+}
+
+TEST(LexerTest, ParallelError) {
+  std::string code;
+  for (int i = 0; i < 20; i++)
+    code += std::string("def f(): int { return ") +
+            (i == 5 ? "1.2.3" : i == 15 ? "4.5.6" : "0") + " }\n";
+  for (unsigned jobs = 1; jobs <= 4; jobs++) {
+    try {
+      tokenize_parallel(code, jobs);
+      FAIL() << "expected std::logic_error";
+    } catch (const std::logic_error &err) {
+      EXPECT_STREQ(err.what(), "malformed number literal: 1.2.3");
+    }
+  }
+}
+
+TEST(LexerTest, Relex) {
+  std::string old_code = "def f(x: int): int {\n"
+                         "  let y: int\n"
+                         "  y = x * 2\n"
+                         "  return y\n"
+                         "}\n";
+  auto tokens = tokenize(old_code);
+  std::string new_code = old_code;
+  new_code.replace(old_code.find("2"), 1, "20 + 1");
+  auto range = relex(tokens, old_code, new_code,
+                     {old_code.find("2"), 1, std::string_view("20 + 1")});
+  EXPECT_EQ(tokens, tokenize(new_code));
+  EXPECT_EQ(range, TokenRange({14, 21}));
+  EXPECT_EQ(tokens[20], Token(TokenKind::Int, "1", 1));
+  EXPECT_EQ(tokens[21].text.data(), new_code.data() + new_code.find("return"));
+}
+
+TEST(LexerTest, RelexMatchesTokenize) {
+  std::string code = "module m\n"
+                     "def f(a: int): float {\n"
+                     "  # comment with def and 1.2.3\n"
+                     "  x = a <= 10 != b\n"
+                     "  return 3.25\n"
+                     "}\n";
+  std::vector<std::string> replacements = {
+      "", "a", "1", " ", "\n", "#", "=", "<", ".5", "\n# x\n", "def",
+      std::string(1, '\0')};
+  for (std::size_t offset = 0; offset <= code.size(); offset++)
+    for (std::size_t length = 0; length <= 3; length++) {
+      if (offset + length > code.size())
+        continue;
+      for (const auto &replacement : replacements) {
+        std::string new_code = code;
+        new_code.replace(offset, length, replacement);
+        std::vector<Token> expected;
+        try {
+          expected = tokenize(new_code);
+        } catch (const std::logic_error &) {
+          continue;
+        }
+        auto tokens = tokenize(code);
+        auto range =
+            relex(tokens, code, new_code, {offset, length, replacement});
+        EXPECT_EQ(tokens, expected) << offset << " " << length << " "
+                                    << replacement;
+        for (std::size_t i = 0; i < tokens.size(); i++)
+          EXPECT_EQ(tokens[i].text.data(), expected[i].text.data());
+        EXPECT_LE(range.end, tokens.size());
+      }
+    }
+}
+
+TEST(LexerTest, TokenBuffer) {
+  std::string code = "def f(x: int): float {\n"
+                     "  return x * 2.5 + 7 # comment\n"
+                     "}\n";
+  TokenBuffer buffer(code);
+  auto tokens = tokenize(code);
+  ASSERT_EQ(buffer.size(), tokens.size());
+  for (std::size_t i = 0; i < tokens.size(); i++) {
+    EXPECT_EQ(buffer[i], tokens[i]);
+    EXPECT_EQ(buffer.text(i).data(), tokens[i].text.data());
+    EXPECT_EQ(buffer.offset(i), tokens[i].text.data() - code.data());
+  }
+  EXPECT_EQ(buffer.kind(tokens.size() - 1), TokenKind::Eof);
+  EXPECT_EQ(buffer.value(13), TokenValue(2.5));
+  EXPECT_EQ(buffer.value(15), TokenValue(std::int64_t(7)));
+
+  TokenBuffer from_tokens(code, tokens);
+  for (std::size_t i = 0; i < tokens.size(); i++)
+    EXPECT_EQ(from_tokens[i], tokens[i]);
+  std::string other = "x";
+  EXPECT_THROW(from_tokens.push_back(Token(TokenKind::Identifier, other)),
+               std::logic_error);
 }
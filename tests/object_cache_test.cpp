@@ -0,0 +1,170 @@
+#include "object_cache.h"
+
+#include <chrono>
+#include <csignal>
+#include <cstddef>
+#include <filesystem>
+#include <memory>
+#include <string>
+
+#include <llvm/ADT/StringRef.h>
+#include <llvm/IR/BasicBlock.h>
+#include <llvm/IR/DerivedTypes.h>
+#include <llvm/IR/Function.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+#include <llvm/Support/MemoryBuffer.h>
+
+#include <sys/resource.h>
+
+#include <gtest/gtest.h>
+
+namespace fs = std::filesystem;
+
+using stapl::jit::ObjectCache;
+
+namespace {
+// Gives each test an empty cache directory.
+class ObjectCacheTest : public testing::Test {
+protected:
+  llvm::LLVMContext context;
+  fs::path directory;
+
+  void SetUp() override {
+    directory =
+        fs::temp_directory_path() /
+        ("stapl_object_cache_test_" +
+         std::string(
+             testing::UnitTest::GetInstance()->current_test_info()->name()));
+    fs::remove_all(directory);
+  }
+
+  void TearDown() override { fs::remove_all(directory); }
+
+  std::unique_ptr<llvm::Module> make_module(const std::string &name) {
+    auto module = std::make_unique<llvm::Module>(name, context);
+    auto *func = llvm::Function::Create(
+        llvm::FunctionType::get(llvm::Type::getVoidTy(context), false),
+        llvm::Function::ExternalLinkage, name, *module);
+    llvm::IRBuilder<> builder(llvm::BasicBlock::Create(context, "entry", func));
+    builder.CreateRetVoid();
+    return module;
+  }
+
+  // Look a module up, and store a fake object for it on a miss.
+  bool lookup_or_store(ObjectCache &cache, const llvm::Module &module,
+                       std::size_t object_size = 100) {
+    if (auto object = cache.getObject(&module)) {
+      EXPECT_EQ(object->getBufferSize(), object_size);
+      return true;
+    }
+    std::string object(object_size, 'x');
+    cache.notifyObjectCompiled(
+        &module, llvm::MemoryBufferRef(llvm::StringRef(object), "object"));
+    return false;
+  }
+
+  bool hits(ObjectCache &cache, const llvm::Module &module) {
+    return cache.getObject(&module) != nullptr;
+  }
+
+  // Make the objects look as if they were last used an hour earlier.
+  void age_objects() {
+    for (const auto &entry : fs::directory_iterator(directory))
+      fs::last_write_time(entry.path(),
+                          entry.last_write_time() - std::chrono::hours(1));
+  }
+
+  std::size_t object_count() {
+    std::size_t count = 0;
+    for (const auto &entry : fs::directory_iterator(directory))
+      count += entry.path().extension() == ".o";
+    return count;
+  }
+};
+} // namespace
+
+TEST_F(ObjectCacheTest, StoreAndLoad) {
+  ObjectCache cache(directory, 1 << 20, "tag");
+  auto module = make_module("f");
+  EXPECT_FALSE(lookup_or_store(cache, *module));
+  EXPECT_EQ(object_count(), 1u);
+  EXPECT_TRUE(lookup_or_store(cache, *module));
+
+  ObjectCache reopened(directory, 1 << 20, "tag");
+  EXPECT_TRUE(hits(reopened, *module));
+  EXPECT_FALSE(hits(reopened, *make_module("g")));
+}
+
+TEST_F(ObjectCacheTest, OnlyStoresMisses) {
+  ObjectCache cache(directory, 1 << 20, "tag");
+  auto module = make_module("f");
+  std::string object(100, 'x');
+  cache.notifyObjectCompiled(
+      module.get(), llvm::MemoryBufferRef(llvm::StringRef(object), "object"));
+  EXPECT_EQ(object_count(), 0u);
+}
+
+TEST_F(ObjectCacheTest, WriteFailure) {
+  ObjectCache cache(directory, 1 << 20, "tag");
+  auto module = make_module("f");
+  // Make writing the object fail with EFBIG, as a full disk would fail it.
+  rlimit old_limit;
+  getrlimit(RLIMIT_FSIZE, &old_limit);
+  rlimit limit = old_limit;
+  limit.rlim_cur = 50;
+  auto old_handler = std::signal(SIGXFSZ, SIG_IGN);
+  setrlimit(RLIMIT_FSIZE, &limit);
+  EXPECT_FALSE(lookup_or_store(cache, *module));
+  setrlimit(RLIMIT_FSIZE, &old_limit);
+  std::signal(SIGXFSZ, old_handler);
+  EXPECT_TRUE(fs::is_empty(directory));
+  EXPECT_FALSE(hits(cache, *module));
+}
+
+TEST_F(ObjectCacheTest, DifferentTag) {
+  auto module = make_module("f");
+  {
+    ObjectCache cache(directory, 1 << 20, "x86_64 O2");
+    EXPECT_FALSE(lookup_or_store(cache, *module));
+  }
+  ObjectCache other(directory, 1 << 20, "x86_64 O3");
+  EXPECT_FALSE(hits(other, *module));
+  ObjectCache same(directory, 1 << 20, "x86_64 O2");
+  EXPECT_TRUE(hits(same, *module));
+}
+
+TEST_F(ObjectCacheTest, EvictsLeastRecentlyUsed) {
+  ObjectCache cache(directory, 250, "tag");
+  auto a = make_module("a");
+  auto b = make_module("b");
+  auto c = make_module("c");
+  EXPECT_FALSE(lookup_or_store(cache, *a));
+  age_objects();
+  EXPECT_FALSE(lookup_or_store(cache, *b));
+  age_objects();
+  // Using ``a`` makes ``b`` the least recently used object.
+  EXPECT_TRUE(lookup_or_store(cache, *a));
+  EXPECT_FALSE(lookup_or_store(cache, *c));
+  EXPECT_EQ(object_count(), 2u);
+  EXPECT_TRUE(hits(cache, *a));
+  EXPECT_FALSE(hits(cache, *b));
+  EXPECT_TRUE(hits(cache, *c));
+}
+
+TEST_F(ObjectCacheTest, EvictsOnOpen) {
+  {
+    ObjectCache cache(directory, 1 << 20, "tag");
+    for (const auto *name : {"a", "b", "c", "d"}) {
+      EXPECT_FALSE(lookup_or_store(cache, *make_module(name)));
+      age_objects();
+    }
+  }
+  ObjectCache cache(directory, 250, "tag");
+  EXPECT_EQ(object_count(), 2u);
+  EXPECT_FALSE(hits(cache, *make_module("a")));
+  EXPECT_FALSE(hits(cache, *make_module("b")));
+  EXPECT_TRUE(hits(cache, *make_module("c")));
+  EXPECT_TRUE(hits(cache, *make_module("d")));
+}
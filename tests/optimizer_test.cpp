@@ -0,0 +1,89 @@
+#include "ast.h"
+#include "irgen.h"
+#include "optimizer.h"
+#include "test_util.h"
+
+#include <cstddef>
+#include <optional>
+#include <stdexcept>
+#include <string_view>
+
+#include <llvm/IR/Function.h>
+#include <llvm/IR/Instructions.h>
+#include <llvm/IR/Module.h>
+#include <llvm/IR/Verifier.h>
+#include <llvm/Support/Casting.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <gtest/gtest.h>
+
+using namespace stapl::opt;
+using stapl::ir::IRGen;
+using stapl::test_util::parse_annotated;
+
+namespace {
+constexpr std::string_view source = R"(module test
+def f(x: int): int {
+  let y: int
+  y = 0
+  while x > 0 {
+    y = y + x
+    x = x - 1
+  }
+  return y
+}
+)";
+
+std::size_t count_allocas(const llvm::Module &module) {
+  std::size_t count = 0;
+  for (const auto &func : module)
+    for (const auto &block : func)
+      for (const auto &inst : block)
+        count += llvm::isa<llvm::AllocaInst>(inst);
+  return count;
+}
+} // namespace
+
+TEST(OptimizerTest, ParseOptLevel) {
+  EXPECT_EQ(parse_opt_level("0"), OptLevel::O0);
+  EXPECT_EQ(parse_opt_level("2"), OptLevel::O2);
+  EXPECT_EQ(parse_opt_level("s"), OptLevel::Os);
+  EXPECT_EQ(parse_opt_level("4"), std::nullopt);
+  EXPECT_EQ(parse_opt_level("fast"), std::nullopt);
+  EXPECT_EQ(parse_opt_level(""), std::nullopt);
+}
+
+TEST(OptimizerTest, InvalidPipeline) {
+  IRGen irgen;
+  auto module_node = parse_annotated(source);
+  irgen.codegen(module_node);
+  EXPECT_THROW(run_passes(irgen.get_module(), "function(no-such-pass)"),
+               std::logic_error);
+  EXPECT_THROW(run_passes(irgen.get_module(), "function(mem2reg"),
+               std::logic_error);
+}
+
+TEST(OptimizerTest, Mem2Reg) {
+  IRGen irgen;
+  auto module_node = parse_annotated(source);
+  irgen.codegen(module_node);
+  auto &module = irgen.get_module();
+  EXPECT_GT(count_allocas(module), 0u);
+  run_passes(module, "function(mem2reg)");
+  EXPECT_EQ(count_allocas(module), 0u);
+  EXPECT_FALSE(llvm::verifyModule(module, &llvm::errs()));
+}
+
+TEST(OptimizerTest, OptimizeModule) {
+  for (auto level : {OptLevel::O0, OptLevel::O1, OptLevel::O2, OptLevel::O3,
+                     OptLevel::Os}) {
+    IRGen irgen;
+    auto module_node = parse_annotated(source);
+    irgen.codegen(module_node);
+    auto &module = irgen.get_module();
+    optimize_module(module, level);
+    EXPECT_FALSE(llvm::verifyModule(module, &llvm::errs()));
+    if (level != OptLevel::O0)
+      EXPECT_EQ(count_allocas(module), 0u);
+  }
+}
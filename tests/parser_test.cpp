@@ -1,8 +1,13 @@
+#include "arena.h"
 #include "ast.h"
+#include "flat_ast.h"
 #include "parser.h"
 #include "util.h"
 
+#include <cstdint>
 #include <memory>
+#include <sstream>
+#include <stdexcept>
 #include <string>
 #include <utility>
 #include <variant>
@@ -27,6 +32,11 @@ TEST(ParserTest, Float) {
   EXPECT_EQ(node.value, std::stod(num));
 }
 
+TEST(ParserTest, IntOutOfRange) {
+  Parser parser("2147483648");
+  EXPECT_THROW(parser.parse_int(), std::logic_error);
+}
+
 TEST(ParserTest, Bool) {
   Parser parser("true false");
   auto node = parser.parse_bool();
@@ -45,8 +55,8 @@ TEST(ParserTest, Prototype) {
 
 TEST(ParserTest, UnaryExpr) {
   Parser parser("-42");
-  ExprNode expected =
-               std::make_unique<UnaryExprNode>("-", LiteralExprNode<int>(42)),
+  ExprNode expected = std::make_unique<UnaryExprNode>(
+               Op::Sub, LiteralExprNode<int>(42)),
            parsed = parser.parse_unary_expr();
   EXPECT_EQ(expected, parsed);
 }
@@ -54,15 +64,15 @@ TEST(ParserTest, UnaryExpr) {
 TEST(ParserTest, UnaryExprWithBinary) {
   Parser parser("+(-42 + -x) == !y");
   ExprNode expected = std::make_unique<BinaryExprNode>(
-               "==",
+               Op::Eq,
                std::make_unique<UnaryExprNode>(
-                   "+", std::make_unique<BinaryExprNode>(
-                            "+",
-                            std::make_unique<UnaryExprNode>(
-                                "-", LiteralExprNode<int>(42)),
-                            std::make_unique<UnaryExprNode>(
-                                "-", VariableExprNode("x")))),
-               std::make_unique<UnaryExprNode>("!", VariableExprNode("y"))),
+                   Op::Add, std::make_unique<BinaryExprNode>(
+                                Op::Add,
+                                std::make_unique<UnaryExprNode>(
+                                    Op::Sub, LiteralExprNode<int>(42)),
+                                std::make_unique<UnaryExprNode>(
+                                    Op::Sub, VariableExprNode("x")))),
+               std::make_unique<UnaryExprNode>(Op::Not, VariableExprNode("y"))),
            parsed = parser.parse_expr();
   EXPECT_EQ(expected, parsed);
 }
@@ -70,28 +80,29 @@ TEST(ParserTest, UnaryExprWithBinary) {
 TEST(ParserTest, Expr) {
   Parser parser("a*a + b*b - c*c + x%m + y/q != 0");
   ExprNode expected = std::make_unique<BinaryExprNode>(
-               "!=",
+               Op::Ne,
                std::make_unique<BinaryExprNode>(
-                   "+",
+                   Op::Add,
                    std::make_unique<BinaryExprNode>(
-                       "+",
+                       Op::Add,
                        std::make_unique<BinaryExprNode>(
-                           "-",
+                           Op::Sub,
                            std::make_unique<BinaryExprNode>(
-                               "+",
+                               Op::Add,
                                std::make_unique<BinaryExprNode>(
-                                   "*", VariableExprNode("a"),
+                                   Op::Mul, VariableExprNode("a"),
                                    VariableExprNode("a")),
                                std::make_unique<BinaryExprNode>(
-                                   "*", VariableExprNode("b"),
+                                   Op::Mul, VariableExprNode("b"),
                                    VariableExprNode("b"))),
                            std::make_unique<BinaryExprNode>(
-                               "*", VariableExprNode("c"),
+                               Op::Mul, VariableExprNode("c"),
                                VariableExprNode("c"))),
-                       std::make_unique<BinaryExprNode>(
-                           "%", VariableExprNode("x"), VariableExprNode("m"))),
-                   std::make_unique<BinaryExprNode>("/", VariableExprNode("y"),
-                                                    VariableExprNode("q"))),
+                       std::make_unique<BinaryExprNode>(Op::Mod,
+                                                        VariableExprNode("x"),
+                                                        VariableExprNode("m"))),
+                   std::make_unique<BinaryExprNode>(
+                       Op::Div, VariableExprNode("y"), VariableExprNode("q"))),
                LiteralExprNode<int>(0)),
            parsed = parser.parse_expr();
   EXPECT_EQ(expected, parsed);
@@ -101,7 +112,7 @@ TEST(ParserTest, CallExpr) {
   Parser parser("f(42, x + y, g(128))");
   auto args = make_vector<ExprNode>(
       LiteralExprNode<int>(42),
-      std::make_unique<BinaryExprNode>("+", VariableExprNode("x"),
+      std::make_unique<BinaryExprNode>(Op::Add, VariableExprNode("x"),
                                        VariableExprNode("y")),
       std::make_unique<CallExprNode>(
           "g", make_vector<ExprNode>(LiteralExprNode<int>(128))));
@@ -113,10 +124,10 @@ TEST(ParserTest, CallExpr) {
 TEST(ParserTest, ParenExpr) {
   Parser parser("(a + b)*(a + b)");
   ExprNode expected = std::make_unique<BinaryExprNode>(
-               "*",
-               std::make_unique<BinaryExprNode>("+", VariableExprNode("a"),
+               Op::Mul,
+               std::make_unique<BinaryExprNode>(Op::Add, VariableExprNode("a"),
                                                 VariableExprNode("b")),
-               std::make_unique<BinaryExprNode>("+", VariableExprNode("a"),
+               std::make_unique<BinaryExprNode>(Op::Add, VariableExprNode("a"),
                                                 VariableExprNode("b"))),
            parsed = parser.parse_expr();
   EXPECT_EQ(expected, parsed);
@@ -132,7 +143,7 @@ TEST(ParserTest, Assign) {
   Parser parser("x = 1 + y");
   StmtNode expected(AssignmentStmtNode(
       "x", ExprNode(std::make_unique<BinaryExprNode>(
-               "+", LiteralExprNode<int>(1), VariableExprNode("y"))))),
+               Op::Add, LiteralExprNode<int>(1), VariableExprNode("y"))))),
       parsed = parser.parse_stmt();
   EXPECT_EQ(parsed, expected);
 }
@@ -148,7 +159,7 @@ TEST(ParserTest, If) {
 })");
   StmtNode expected(std::make_unique<CompoundStmtNode>(make_vector<StmtNode>(
       std::make_unique<IfStmtNode>(
-          std::make_unique<BinaryExprNode>("==", VariableExprNode("x"),
+          std::make_unique<BinaryExprNode>(Op::Eq, VariableExprNode("x"),
                                            VariableExprNode("y")),
           std::make_unique<CompoundStmtNode>(make_vector<StmtNode>(
               LetStmtNode("z", "int"),
@@ -181,7 +192,7 @@ TEST(ParserTest, IfElse) {
            AssignmentStmtNode(
                "w", std::make_unique<CallExprNode>("f", std::move(call_args))));
   StmtNode expected(std::make_unique<IfStmtNode>(
-      std::make_unique<BinaryExprNode>("==", VariableExprNode("x"),
+      std::make_unique<BinaryExprNode>(Op::Eq, VariableExprNode("x"),
                                        VariableExprNode("y")),
       std::make_unique<CompoundStmtNode>(std::move(then_stmt_vec)),
       std::make_unique<CompoundStmtNode>(std::move(else_stmt_vec)))),
@@ -211,11 +222,11 @@ TEST(ParserTest, IfElseifElse) {
        else_else_stmt_vec = make_vector<StmtNode>(
            AssignmentStmtNode("y", LiteralExprNode<int>(0)));
   StmtNode expected(std::make_unique<IfStmtNode>(
-      std::make_unique<BinaryExprNode>("==", VariableExprNode("x"),
+      std::make_unique<BinaryExprNode>(Op::Eq, VariableExprNode("x"),
                                        VariableExprNode("y")),
       std::make_unique<CompoundStmtNode>(std::move(then_stmt_vec)),
       std::make_unique<IfStmtNode>(
-          std::make_unique<BinaryExprNode>(">", VariableExprNode("x"),
+          std::make_unique<BinaryExprNode>(Op::Gt, VariableExprNode("x"),
                                            VariableExprNode("y")),
           std::make_unique<CompoundStmtNode>(std::move(else_if_stmt_vec)),
           std::make_unique<CompoundStmtNode>(std::move(else_else_stmt_vec))))),
@@ -235,24 +246,24 @@ TEST(ParserTest, While) {
 })");
   auto while_body = make_vector<StmtNode>(
       std::make_unique<IfStmtNode>(
-          std::make_unique<BinaryExprNode>("==", VariableExprNode("x"),
+          std::make_unique<BinaryExprNode>(Op::Eq, VariableExprNode("x"),
                                            LiteralExprNode<int>(0)),
           std::make_unique<CompoundStmtNode>(
               make_vector<StmtNode>(ContinueStmtNode())),
           std::make_unique<IfStmtNode>(
-              std::make_unique<BinaryExprNode>(">", VariableExprNode("x"),
+              std::make_unique<BinaryExprNode>(Op::Gt, VariableExprNode("x"),
                                                LiteralExprNode<int>(0)),
               std::make_unique<CompoundStmtNode>(
                   make_vector<StmtNode>(BreakStmtNode())),
               std::make_unique<CompoundStmtNode>(std::vector<StmtNode>()))),
       AssignmentStmtNode(
-          "x", std::make_unique<BinaryExprNode>("+", VariableExprNode("x"),
+          "x", std::make_unique<BinaryExprNode>(Op::Add, VariableExprNode("x"),
                                                 LiteralExprNode<int>(1))),
       AssignmentStmtNode(
           "y", std::make_unique<CallExprNode>(
                    "f", make_vector<ExprNode>(VariableExprNode("x")))));
   StmtNode expected = std::make_unique<WhileStmtNode>(
-               std::make_unique<BinaryExprNode>("==", VariableExprNode("x"),
+               std::make_unique<BinaryExprNode>(Op::Eq, VariableExprNode("x"),
                                                 VariableExprNode("y")),
                std::make_unique<CompoundStmtNode>(std::move(while_body))),
            parsed = parser.parse_while();
@@ -262,9 +273,9 @@ TEST(ParserTest, While) {
 TEST(ParserTest, Return) {
   Parser parser("return f(42) + 10 - x");
   StmtNode expected(ReturnStmtNode(std::make_unique<BinaryExprNode>(
-      "-",
+      Op::Sub,
       std::make_unique<BinaryExprNode>(
-          "+",
+          Op::Add,
           std::make_unique<CallExprNode>(
               "f", make_vector<ExprNode>(LiteralExprNode<int>(42))),
           LiteralExprNode<int>(10)),
@@ -322,7 +333,7 @@ TEST(ParserTest, Def) {
                "z", std::make_unique<CallExprNode>(
                         "g", make_vector<ExprNode>(VariableExprNode("y")))),
            std::make_unique<IfStmtNode>(
-               std::make_unique<BinaryExprNode>(">=", VariableExprNode("x"),
+               std::make_unique<BinaryExprNode>(Op::Ge, VariableExprNode("x"),
                                                 VariableExprNode("z")),
                std::make_unique<CompoundStmtNode>(std::move(then_stmts)),
                std::make_unique<CompoundStmtNode>(std::move(else_stmts))));
@@ -332,3 +343,104 @@ TEST(ParserTest, Def) {
       parsed = parser.parse_def();
   EXPECT_EQ(expected, parsed);
 }
+
+TEST(ParserTest, Tokens) {
+  std::string code = R"(module test
+extern g(x: int): int
+def f(x: int): int {
+  return g(x) + 1
+}
+)";
+  Parser parser(code),
+      token_parser(TokenBuffer(code, tokenize_parallel(code, 2)));
+  auto expected = parser.parse_module(), parsed = token_parser.parse_module();
+  EXPECT_EQ(expected.name, parsed.name);
+  EXPECT_EQ(expected.decls, parsed.decls);
+}
+
+TEST(ParserTest, Peek) {
+  std::string code = "let x: int\nx = f(1)\nf(x)";
+  Parser parser(code);
+  EXPECT_EQ(parser.parse_stmt(), StmtNode(LetStmtNode("x", "int")));
+  EXPECT_EQ(parser.parse_stmt(),
+            StmtNode(AssignmentStmtNode(
+                "x", std::make_unique<CallExprNode>(
+                         "f", make_vector<ExprNode>(LiteralExprNode(1))))));
+  EXPECT_EQ(parser.parse_stmt(),
+            StmtNode(AssignmentStmtNode(
+                "_", std::make_unique<CallExprNode>(
+                         "f", make_vector<ExprNode>(VariableExprNode("x"))))));
+
+  std::istringstream input(code);
+  Parser stream_parser(input);
+  EXPECT_EQ(stream_parser.parse_stmt(), StmtNode(LetStmtNode("x", "int")));
+  EXPECT_EQ(stream_parser.parse_stmt(),
+            StmtNode(AssignmentStmtNode(
+                "x", std::make_unique<CallExprNode>(
+                         "f", make_vector<ExprNode>(LiteralExprNode(1))))));
+}
+
+TEST(ParserTest, LetWithoutColon) {
+  Parser parser("let x int");
+  EXPECT_THROW(parser.parse_let(), std::logic_error);
+}
+
+TEST(ParserTest, ModuleArena) {
+  Parser parser(R"(module test
+def f(x: int): int {
+  while x > 0 {
+    x = x - g(x, -1)
+  }
+  return x
+}
+)");
+  auto module = parser.parse_module();
+  ASSERT_NE(module.arena, nullptr);
+  EXPECT_GT(module.arena->bytes_used(), 0u);
+  EXPECT_GE(module.arena->bytes_reserved(), module.arena->bytes_used());
+  EXPECT_EQ(Arena::current(), nullptr);
+
+  Module moved = std::move(module);
+  auto &body = std::get<FunctionDeclNode>(moved.decls[0]).func_body;
+  auto &stmts = std::get<std::unique_ptr<CompoundStmtNode>>(*body)->stmts;
+  EXPECT_EQ(stmts.size(), 2u);
+  moved = Module("empty", {});
+  EXPECT_EQ(moved.arena, nullptr);
+}
+
+TEST(ParserTest, Flatten) {
+  Parser parser(R"(module test
+extern g(x: int, y: int): int
+def f(x: int): int {
+  let y: int
+  while x > 0 {
+    y = g(x, -y) * 2
+  }
+  return y
+}
+)");
+  auto flat = flatten(parser.parse_module());
+  EXPECT_EQ(flat.name, "test");
+  ASSERT_EQ(flat.functions.size(), 2u);
+  EXPECT_FALSE(flat.functions[0].func_body.has_value());
+  EXPECT_EQ(flat.lets.size(), 1u);
+  EXPECT_EQ(flat.whiles.size(), 1u);
+  EXPECT_EQ(flat.compounds.size(), 2u);
+  EXPECT_EQ(flat.stmt_lists.size(), 4u);
+
+  // x > 0 | x y - g 2 * | y
+  auto &exprs = flat.exprs;
+  ASSERT_EQ(exprs.size(), 10u);
+  EXPECT_EQ(flat.whiles[0].condition, IndexRange({0, 3}));
+  EXPECT_EQ(flat.assignments[0].assign_expr, IndexRange({3, 9}));
+  EXPECT_EQ(flat.returns[0].return_expr, IndexRange({9, 10}));
+  EXPECT_EQ(exprs.kinds[6], FlatExprKind::Call);
+  EXPECT_EQ(exprs.payloads[6], Symbol("g").id());
+  EXPECT_EQ(exprs.children(6), std::vector<NodeIndex>({3, 5}));
+  EXPECT_EQ(exprs.subtree(6), IndexRange({3, 7}));
+  EXPECT_EQ(exprs.kinds[8], FlatExprKind::Binary);
+  EXPECT_EQ(exprs.payloads[8], static_cast<std::uint32_t>(Op::Mul));
+  EXPECT_EQ(exprs.children(8), std::vector<NodeIndex>({6, 7}));
+  EXPECT_EQ(exprs.subtree(8), IndexRange({3, 9}));
+  EXPECT_EQ(exprs.payloads[7], 2u);
+}
@@ -0,0 +1,76 @@
+#include "symbol.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace stapl::util;
+
+TEST(SymbolTest, Str) {
+  Symbol symbol("foo");
+  EXPECT_EQ(symbol.str(), "foo");
+  EXPECT_EQ(Symbol().str(), "");
+  EXPECT_EQ(Symbol().id(), 0u);
+}
+
+TEST(SymbolTest, SameName) {
+  std::string name = "bar";
+  Symbol a("bar"), b(name), c{std::string_view(name)};
+  EXPECT_EQ(a, b);
+  EXPECT_EQ(a, c);
+  EXPECT_EQ(a.id(), b.id());
+  EXPECT_NE(a, Symbol("baz"));
+  EXPECT_EQ(std::hash<Symbol>()(a), a.id());
+}
+
+TEST(SymbolTest, FromId) {
+  Symbol symbol("qux");
+  auto restored = Symbol::from_id(symbol.id());
+  EXPECT_EQ(restored, symbol);
+  EXPECT_EQ(restored.str(), "qux");
+}
+
+TEST(InternerTest, Intern) {
+  Interner interner;
+  EXPECT_EQ(interner.size(), 1u);
+  EXPECT_EQ(interner.intern(""), 0u);
+  auto x = interner.intern("x");
+  auto y = interner.intern("y");
+  EXPECT_NE(x, y);
+  EXPECT_EQ(interner.intern("x"), x);
+  EXPECT_EQ(interner.name(y), "y");
+  EXPECT_EQ(interner.size(), 3u);
+}
+
+TEST(InternerTest, Threads) {
+  constexpr std::size_t thread_count = 8;
+  constexpr std::size_t name_count = 1000;
+  Interner interner;
+  std::vector<std::vector<std::uint32_t>> ids(
+      thread_count, std::vector<std::uint32_t>(name_count));
+  std::vector<std::thread> threads;
+  for (std::size_t t = 0; t < thread_count; t++)
+    threads.emplace_back([&interner, &ids, t] {
+      // Each thread walks the names in a different order, so that threads
+      // race to intern the same names.
+      for (std::size_t i = 0; i < name_count; i++) {
+        auto n = (i + t * 37) % name_count;
+        ids[t][n] = interner.intern("name" + std::to_string(n));
+      }
+    });
+  for (auto &thread : threads)
+    thread.join();
+
+  EXPECT_EQ(interner.size(), name_count + 1);
+  for (std::size_t n = 0; n < name_count; n++) {
+    for (std::size_t t = 1; t < thread_count; t++)
+      EXPECT_EQ(ids[t][n], ids[0][n]);
+    EXPECT_EQ(interner.name(ids[0][n]), "name" + std::to_string(n));
+  }
+}
@@ -0,0 +1,86 @@
+#include "ast.h"
+#include "irgen.h"
+#include "optimizer.h"
+#include "target.h"
+#include "test_util.h"
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include <llvm/IR/Module.h>
+
+#include <gtest/gtest.h>
+
+using namespace stapl::target;
+using stapl::ir::IRGen;
+using stapl::opt::OptLevel;
+using stapl::test_util::parse_annotated;
+
+namespace {
+constexpr std::string_view source = R"(module test
+def f(x: int, y: int): int {
+  return x * y + 1
+}
+)";
+
+std::string read_file(const std::filesystem::path &path) {
+  std::ifstream in(path, std::ios::binary);
+  return {std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+}
+
+std::filesystem::path temp_path(const std::string &name) {
+  return std::filesystem::temp_directory_path() /
+         ("stapl_target_test_" + name);
+}
+} // namespace
+
+TEST(TargetTest, UnsupportedTriple) {
+  TargetOptions options;
+  options.triple = "nonexistent-unknown-unknown";
+  EXPECT_THROW(create_target_machine(options), std::logic_error);
+}
+
+TEST(TargetTest, SetTarget) {
+  auto machine = create_target_machine({});
+  IRGen irgen;
+  auto module_node = parse_annotated(source);
+  irgen.codegen(module_node);
+  set_target(irgen.get_module(), *machine);
+  EXPECT_EQ(irgen.get_module().getTargetTriple(),
+            machine->getTargetTriple().str());
+  EXPECT_FALSE(irgen.get_module().getDataLayout().isDefault());
+}
+
+TEST(TargetTest, EmitHostFiles) {
+  TargetOptions options;
+  options.cpu = "native";
+  options.opt_level = OptLevel::O2;
+  auto machine = create_target_machine(options);
+  for (auto kind : {FileKind::Object, FileKind::Assembly}) {
+    IRGen irgen;
+    auto module_node = parse_annotated(source);
+    irgen.codegen(module_node);
+    set_target(irgen.get_module(), *machine);
+    auto path = temp_path(kind == FileKind::Object ? "f.o" : "f.s");
+    emit_file(irgen.get_module(), *machine, path.string(), kind);
+    auto contents = read_file(path);
+    std::filesystem::remove(path);
+    EXPECT_FALSE(contents.empty());
+  }
+}
+
+TEST(TargetTest, UnwritableOutput) {
+  auto machine = create_target_machine({});
+  IRGen irgen;
+  auto module_node = parse_annotated(source);
+  irgen.codegen(module_node);
+  set_target(irgen.get_module(), *machine);
+  auto path = temp_path("missing") / "f.o";
+  EXPECT_THROW(
+      emit_file(irgen.get_module(), *machine, path.string(), FileKind::Object),
+      std::logic_error);
+}
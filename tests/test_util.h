@@ -0,0 +1,22 @@
+#pragma once
+
+#include "annotator.h"
+#include "ast.h"
+#include "parser.h"
+
+#include <string_view>
+
+namespace stapl::test_util {
+/**
+ * @brief Parse and type check a module, as the phases after type checking
+ * expect.
+ * @param code The code of the module.
+ * @return The annotated module.
+ */
+inline ast::Module parse_annotated(std::string_view code) {
+  parsing::Parser parser(code);
+  auto module = parser.parse_module();
+  types::annotate_module(module, 1);
+  return module;
+}
+} // namespace stapl::test_util